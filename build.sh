@@ -2,7 +2,7 @@
 
 # Install required packages
 DEBIAN_FRONTEND=noninteractive sudo apt update -y
-DEBIAN_FRONTEND=noninteractive sudo apt install -y libssl-dev libcurl4-openssl-dev libeigen3-dev zip libyaml-cpp-dev libspdlog-dev
+DEBIAN_FRONTEND=noninteractive sudo apt install -y libssl-dev libcurl4-openssl-dev libeigen3-dev zip libyaml-cpp-dev libspdlog-dev zlib1g-dev
 
 mkdir -p external/stepcode/build
 pushd external/stepcode/build
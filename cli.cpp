@@ -17,6 +17,8 @@ class GraphSTEPCLI {
         std::cout << "  create [FILENAME]               Create a graph from a STEP file" << std::endl;
         std::cout << "  delete                          Delete the database" << std::endl;
         std::cout << "  read                            Read the database" << std::endl;
+        std::cout << "  read-stream [DIR]               Read the database, records are written while they are received" << std::endl;
+        std::cout << "  export-import-csv [FILENAME] [DIR] Write CSV files of a STEP file for neo4j-admin import" << std::endl;
         std::cout << "  filter                          Filter the database" << std::endl;
         std::cout << "  restore-filter                  Restores the unfiltered state of the productgraph" << std::endl;
         std::cout << "  filter-brep [PARTNAME]          Filter the boundary representation of a part" << std::endl;
@@ -38,7 +40,7 @@ class GraphSTEPCLI {
         return 0;
     }
 
-    int readGraph(std::string outputDirectory) {
+    int readGraph(std::string outputDirectory, bool stream = false) {
         auto databaseInfo = getDatabaseConfig();
         std::string out = "";
         if (outputDirectory.empty()) {
@@ -47,10 +49,21 @@ class GraphSTEPCLI {
             out = outputDirectory + databaseInfo.databaseName + "_out.stp";
         }
         PullSTEP database(out, databaseInfo);
+        if (stream) return database.writeStepStream();
+
         database.writeStep();
         return 0;
     }
 
+    int exportImportCsv(std::string filePath, std::string outputDirectory) {
+        PushSTEP exporter(filePath);
+
+        if (!exporter.exportImportCsv(outputDirectory)) {
+            return -1;
+        }
+        return 0;
+    }
+
     int deleteDatabase() {
         auto databaseInfo = getDatabaseConfig();
         Graph graph(databaseInfo);
@@ -219,6 +232,22 @@ int main(int argc, char* argv[]) {
         std::string outputDirectory = argv[2];
         return graphCLI.readGraph(outputDirectory);
     }
+    else if (command == "export-import-csv") {
+        if (argc != 4) {
+            std::cout << "Error: Invalid number of arguments for export-import-csv command.\n";
+            graphCLI.printHelp();
+            return 1;
+        }
+        return graphCLI.exportImportCsv(std::string(argv[2]), std::string(argv[3]));
+    }
+    else if (command == "read-stream") {
+        if (argc != 3) {
+            std::cout << "Error: Invalid number of arguments for read-stream command.\n";
+            graphCLI.printHelp();
+            return 1;
+        }
+        return graphCLI.readGraph(std::string(argv[2]), true);
+    }
     else if (command == "move-part") {
         if (argc != 6) {
             std::cout << "Error: Invalid number of arguments for move-part command.\n";
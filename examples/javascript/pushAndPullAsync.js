@@ -0,0 +1,30 @@
+var addon = require("bindings")("graphstepAddon");
+
+const databaseInfo = {
+    host: 'http://localhost:7474/',
+    database: 'pointcloud',
+    user: {
+        name: 'neo4j',
+        password: 'testpassword'
+    }
+};
+
+// The *Async functions run on the libuv thread pool and return promises,
+// the event loop (e.g. an Express.js server) keeps serving requests.
+async function pushAndPull() {
+    var inputPath = "data/testfile.stp";
+    var outputDir = "data/out.stp";
+
+    try {
+        await addon.pushFileAsync(inputPath, JSON.stringify(databaseInfo));
+        await addon.pullFileAsync(outputDir, JSON.stringify(databaseInfo));
+
+        const hierarchy = JSON.parse(
+            await addon.getProductHierarchyAsync(JSON.stringify(databaseInfo)));
+        console.log(JSON.stringify(hierarchy));
+    } catch (error) {
+        console.error(error.message);
+    }
+}
+
+pushAndPull();
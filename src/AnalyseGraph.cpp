@@ -14,29 +14,12 @@ void GraphAnalyser::analyseGraph() {
 }
 
 void GraphAnalyser::determineNumNodes() {
-    
     //MATCH (n) RETURN count(n) as count
-
-    Node node;
-    node.setVariable("a");
-
-    std::string query = m_cypher.matchQuery(node, "count(n) as count");
-    std::string response = sendQuery(query);
-
-    if (!response.empty()) {
-        json data = json::parse(response);
-        m_numNodes = data["results"][0]["data"][0]["row"][0];
-    }
+    m_numNodes = countNodes();
 }
 
 void GraphAnalyser::determineNumEdges() {
-    std::string query = "MATCH ()-[r]->() \n RETURN count(r) as count";
-    std::string response = sendQuery(query);
-
-    if (!response.empty()) {
-        json data = json::parse(response);
-        m_numEdges = data["results"][0]["data"][0]["row"][0];
-    }
+    m_numEdges = countRelations();
 }
 
 void GraphAnalyser::determineProductHierarchy() {
@@ -0,0 +1,216 @@
+#include "BlobCodec.h"
+
+namespace {
+// record: length, tag, fields
+// header: version; modified: node id, old property, new property
+// node: label, id, properties; relation: from, to, relation
+constexpr uint64_t BLOB_VERSION = 1;
+constexpr uint64_t RECORD_HEADER = 0;
+constexpr uint64_t RECORD_MODIFIED = 1;
+constexpr uint64_t RECORD_NODE = 2;
+constexpr uint64_t RECORD_RELATION = 3;
+
+// pending records are compressed once they exceed this size
+constexpr size_t PENDING_SIZE = 64 << 10;
+}  // namespace
+
+BlobEncoder::BlobEncoder(bool compress, size_t chunkSize, ChunkCallback onChunk)
+    : m_chunkSize(chunkSize), m_onChunk(std::move(onChunk)) {
+    if (compress) m_deflater = std::make_unique<Deflater>();
+
+    m_record.writeVarint(RECORD_HEADER);
+    m_record.writeVarint(BLOB_VERSION);
+    writeRecord();
+}
+
+BlobEncoder::~BlobEncoder() {}
+
+void BlobEncoder::add(const Modified &modified) {
+    m_record.writeVarint(RECORD_MODIFIED);
+    m_record.writeString(modified.nodeId);
+    m_record.writeString(modified.propertyOld.variable);
+    m_record.writeString(modified.propertyOld.value);
+    m_record.writeString(modified.propertyNew.variable);
+    m_record.writeString(modified.propertyNew.value);
+    writeRecord();
+}
+
+void BlobEncoder::add(Node &node) {
+    m_record.writeVarint(RECORD_NODE);
+    m_record.writeString(node.getLabel());
+    m_record.writeString(node.getId());
+
+    std::vector<Property> properties = node.getProperties();
+    m_record.writeVarint(properties.size());
+    for (auto &property : properties) {
+        m_record.writeString(property.variable);
+        m_record.writeString(property.value);
+    }
+    writeRecord();
+}
+
+void BlobEncoder::add(const Relation &relation) {
+    m_record.writeVarint(RECORD_RELATION);
+    m_record.writeString(relation.nodeIdFrom);
+    m_record.writeString(relation.nodeIdTo);
+    m_record.writeString(relation.relation);
+    writeRecord();
+}
+
+void BlobEncoder::add(Blob &blob) {
+    // same order as the changes are loaded
+    for (auto &modified : blob.getModified()) add(modified);
+    for (auto &node : blob.getNewNodes()) add(node);
+    for (auto &relation : blob.getNewRelations()) add(relation);
+}
+
+void BlobEncoder::finish() {
+    flushRecords();
+
+    if (m_deflater) {
+        std::string compressed;
+        m_deflater->finish(compressed);
+        output(compressed);
+    }
+
+    if (!m_chunk.empty()) m_onChunk(m_chunk);
+    m_chunk.clear();
+}
+
+void BlobEncoder::writeRecord() {
+    std::string record = m_record.release();
+
+    ByteWriter length;
+    length.writeVarint(record.size());
+    m_pending += length.data();
+    m_pending += record;
+
+    if (m_pending.size() >= PENDING_SIZE) flushRecords();
+}
+
+void BlobEncoder::flushRecords() {
+    if (!m_deflater) {
+        output(m_pending);
+    } else {
+        std::string compressed;
+        m_deflater->write(m_pending, compressed);
+        output(compressed);
+    }
+    m_pending.clear();
+}
+
+void BlobEncoder::output(std::string_view data) {
+    while (!data.empty()) {
+        size_t size = std::min(data.size(), m_chunkSize - m_chunk.size());
+        m_chunk.append(data.data(), size);
+        data.remove_prefix(size);
+
+        if (m_chunk.size() == m_chunkSize) {
+            m_onChunk(m_chunk);
+            m_chunk.clear();
+        }
+    }
+}
+
+BlobDecoder::BlobDecoder(const std::string &encoding,
+                         ModifiedCallback onModified, NodeCallback onNode,
+                         RelationCallback onRelation)
+    : m_onModified(std::move(onModified)),
+      m_onNode(std::move(onNode)),
+      m_onRelation(std::move(onRelation)) {
+    if (encoding == BLOB_ENCODING_ZLIB)
+        m_inflater = std::make_unique<Inflater>();
+    else if (encoding != BLOB_ENCODING_RAW)
+        throw_database_error("unknown blob encoding \"" + encoding + "\"");
+}
+
+BlobDecoder::~BlobDecoder() {}
+
+void BlobDecoder::write(std::string_view chunk) {
+    if (m_inflater)
+        m_inflater->write(chunk, m_buffer);
+    else
+        m_buffer.append(chunk.data(), chunk.size());
+
+    readRecords();
+}
+
+void BlobDecoder::finish() {
+    if ((m_inflater && !m_inflater->finished()) || !m_buffer.empty() ||
+        !m_headerRead)
+        throw_database_error("truncated blob");
+}
+
+void BlobDecoder::readRecords() {
+    size_t position = 0;
+
+    while (position < m_buffer.size()) {
+        // the length may be incomplete as well
+        uint64_t length = 0;
+        size_t cursor = position;
+        bool complete = false;
+        for (int shift = 0; cursor < m_buffer.size() && shift < 64;
+             shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(m_buffer[cursor++]);
+            length |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete || length > m_buffer.size() - cursor) break;
+
+        ByteReader reader(std::string_view(m_buffer).substr(cursor, length));
+        readRecord(reader);
+        position = cursor + length;
+    }
+
+    m_buffer.erase(0, position);
+}
+
+void BlobDecoder::readRecord(ByteReader &reader) {
+    uint64_t tag = reader.readVarint();
+
+    if (!m_headerRead) {
+        if (tag != RECORD_HEADER || reader.readVarint() != BLOB_VERSION)
+            throw_database_error("unsupported blob version");
+        m_headerRead = true;
+        return;
+    }
+
+    switch (tag) {
+        case RECORD_MODIFIED: {
+            Modified modified;
+            modified.nodeId = reader.readString();
+            modified.propertyOld.variable = reader.readString();
+            modified.propertyOld.value = reader.readString();
+            modified.propertyNew.variable = reader.readString();
+            modified.propertyNew.value = reader.readString();
+            m_onModified(modified);
+            break;
+        }
+        case RECORD_NODE: {
+            Node node;
+            node.setLabel(reader.readString());
+            node.setId(reader.readString());
+
+            for (uint64_t count = reader.readVarint(); count > 0; --count) {
+                std::string variable = reader.readString();
+                node.addProperty(
+                    {.variable = variable, .value = reader.readString()});
+            }
+            m_onNode(node);
+            break;
+        }
+        case RECORD_RELATION: {
+            Relation relation;
+            relation.nodeIdFrom = reader.readString();
+            relation.nodeIdTo = reader.readString();
+            relation.relation = reader.readString();
+            m_onRelation(relation);
+            break;
+        }
+        default:
+            throw_database_error("invalid blob record");
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "ByteCodec.hpp"
+#include "Compression.h"
+#include "VersionControl.h"
+
+/**
+ * @brief BlobCodec
+ * binary encoding of the changes of a commit (Blob)
+ * every change is a length prefixed record (see ByteCodec), the records are
+ * optionally compressed (zlib) and split into chunks of a fixed size.
+ * Encoder and decoder work on one chunk at a time, values are kept unchanged
+**/
+
+// encodings stored with the commit
+const std::string BLOB_ENCODING_RAW = "raw";
+const std::string BLOB_ENCODING_ZLIB = "zlib";
+
+class BlobEncoder {
+   public:
+    // called with every completed chunk, in order
+    using ChunkCallback = std::function<void(std::string &chunk)>;
+
+    BlobEncoder(bool compress, size_t chunkSize, ChunkCallback onChunk);
+    ~BlobEncoder();
+
+    void add(const Modified &modified);
+    void add(Node &node);
+    void add(const Relation &relation);
+
+    // all changes of the blob
+    void add(Blob &blob);
+
+    // writes the remaining records, the last chunk may be smaller
+    void finish();
+
+    std::string getEncoding() {
+        return m_deflater ? BLOB_ENCODING_ZLIB : BLOB_ENCODING_RAW;
+    }
+
+   private:
+    // appends m_record with its length to the pending records
+    void writeRecord();
+
+    // passes the pending records to the compression
+    void flushRecords();
+
+    // appends encoded data to the chunk, calls onChunk for full chunks
+    void output(std::string_view data);
+
+    std::unique_ptr<Deflater> m_deflater;  // nullptr: not compressed
+    size_t m_chunkSize;
+    ChunkCallback m_onChunk;
+
+    ByteWriter m_record;
+    std::string m_pending;
+    std::string m_chunk;
+};
+
+class BlobDecoder {
+   public:
+    using ModifiedCallback = std::function<void(Modified &modified)>;
+    using NodeCallback = std::function<void(Node &node)>;
+    using RelationCallback = std::function<void(Relation &relation)>;
+
+    // the callbacks are called in the order the changes were added
+    BlobDecoder(const std::string &encoding, ModifiedCallback onModified,
+                NodeCallback onNode, RelationCallback onRelation);
+    ~BlobDecoder();
+
+    // decodes the records completed by the chunk
+    void write(std::string_view chunk);
+
+    // throws if the data ends within a record
+    void finish();
+
+   private:
+    void readRecords();
+    void readRecord(ByteReader &reader);
+
+    std::unique_ptr<Inflater> m_inflater;  // nullptr: not compressed
+
+    ModifiedCallback m_onModified;
+    NodeCallback m_onNode;
+    RelationCallback m_onRelation;
+
+    // decoded data not read yet (at most one incomplete record)
+    std::string m_buffer;
+    bool m_headerRead = false;
+};
@@ -1,6 +1,20 @@
 #include "FilterGraph.h"
+
+#include <unordered_set>
+
 #include "ManipulateGraph.h"
 
+namespace {
+// same layout as the rows of the bulk ingest (see PushSTEP)
+json nodeToRow(Node node) {
+    json row;
+    row["Id"] = node.getId();
+    for (auto &property : node.getProperties())
+        row[property.variable] = cypherStringToValue(property.value);
+    return row;
+}
+}  // namespace
+
 FilterGraph::FilterGraph() {}
 
 FilterGraph::FilterGraph(DatabaseInfo makroGraphInfo)
@@ -45,38 +59,72 @@ void FilterGraph::replace(DatabaseInfo databaseInfo) {
     std::unique_ptr<Graph> mainDatabase =
         std::make_unique<Graph>(databaseInfo);
 
-    for (auto &subgraph : m_SubGraphs) {
-        auto subgraphNodes = subgraph.getNodes();
-        for (auto it = subgraphNodes.begin(); it != subgraphNodes.end(); ++it) {
-            // Modify first node --> point that will be linked with the main
-            // graph later
-            if (it == subgraphNodes.begin()) {
-                Property property = {.variable = "isMacro",
-                                     .value = makeString("true")};
-
-                Node modified = *it;
-                it->removeProperty(property);
-
-                // Overwrite properties of the current node
-                mainDatabase->modifyNode(*it, modified);
-            } else {
-                // delete the other ones (are already stored in makro database)
-                mainDatabase->deleteNode(*it);
-            }
-        }
-    }
+    replaceSubgraphs(*mainDatabase, nullptr);
 }
 
 void FilterGraph::replace(DatabaseInfo databaseInfo, Node link) {
     std::unique_ptr<Graph> mainDatabase =
         std::make_unique<Graph>(databaseInfo);
 
+    replaceSubgraphs(*mainDatabase, &link);
+}
+
+void FilterGraph::replaceSubgraphs(Graph &mainDatabase, const Node *link) {
+    if (mainDatabase.hasBackend())
+        return replaceSubgraphsPerNode(mainDatabase, link);
+
+    Stopwatch stopwatch;
+
+    // the same node may belong to several subgraphs
+    std::vector<std::string> macroIds;
+    std::vector<std::string> deleteIds;
+    std::unordered_set<std::string> seen;
+
+    for (auto &subgraph : m_SubGraphs) {
+        auto subgraphNodes = subgraph.getNodes();
+        for (size_t index = 0; index < subgraphNodes.size(); ++index) {
+            Node &node = subgraphNodes[index];
+            bool isLink = link ? node.compare(*link) : index == 0;
+
+            if (isLink)
+                macroIds.push_back(node.getId());
+            else if (seen.insert(node.getId()).second)
+                deleteIds.push_back(node.getId());
+        }
+    }
+
+    stopwatch.stop();
+    Logger::log("replace: collected " + std::to_string(macroIds.size()) +
+                " macros and " + std::to_string(deleteIds.size()) +
+                " nodes in " + std::to_string(stopwatch.getElapsedTime()) +
+                " s");
+    stopwatch.restart();
+
+    // point that will be linked with the main graph later
+    mainDatabase.pushBatchedQueries(m_cypher.setPropertyQuery("isMacro"),
+                                    "ids", macroIds, {{"value", "true"}});
+
+    // the other nodes are already stored in the makro database
+    mainDatabase.pushBatchedQueries(m_cypher.deleteNodesQuery(), "ids",
+                                    deleteIds);
+
+    mainDatabase.sendQueries();
+
+    stopwatch.stop();
+    Logger::log("replace: updated the main database in " +
+                std::to_string(stopwatch.getElapsedTime()) + " s");
+}
+
+void FilterGraph::replaceSubgraphsPerNode(Graph &mainDatabase,
+                                          const Node *link) {
     for (auto &subgraph : m_SubGraphs) {
         auto subgraphNodes = subgraph.getNodes();
         for (auto it = subgraphNodes.begin(); it != subgraphNodes.end(); ++it) {
             // Modify first node --> point that will be linked with the main
             // graph later
-            if (it->compare(link)) {
+            bool isLink =
+                link ? it->compare(*link) : it == subgraphNodes.begin();
+            if (isLink) {
                 Property property = {.variable = "isMacro",
                                      .value = makeString("true")};
 
@@ -84,10 +132,10 @@ void FilterGraph::replace(DatabaseInfo databaseInfo, Node link) {
                 it->removeProperty(property);
 
                 // Overwrite properties of the current node
-                mainDatabase->modifyNode(*it, modified);
+                mainDatabase.modifyNode(*it, modified);
             } else {
                 // delete the other ones (are already stored in makro database)
-                mainDatabase->deleteNode(*it);
+                mainDatabase.deleteNode(*it);
             }
         }
     }
@@ -96,58 +144,93 @@ void FilterGraph::replace(DatabaseInfo databaseInfo, Node link) {
 void FilterGraph::loadSubgraphs() {
     m_SubGraphs.clear();
 
-    Node node;
-    node.setVariable("a");
     Property property = {.variable = "isMacro", .value = makeString("true")};
 
-    std::string query = m_cypher.conditionQuery(node, property, "a, labels(a)");
+    Node node;
+    node.addProperty(property);
 
-    std::string jsonString = sendQuery(query);
+    std::vector<Node> nodes = matchNodes(node);
 
-    std::vector<Node> nodes;
+    for (auto &node : nodes) {
+        AdjacencyMatrix subgraph = getSubgraph(node);
+        node.removeProperty(property);
+        m_SubGraphs.push_back(subgraph);
+    }
+}
+
+void FilterGraph::restore() {
+    if (m_main->hasBackend()) return restorePerNode();
 
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
+    Stopwatch stopwatch;
+    loadSubgraphs();
+
+    stopwatch.stop();
+    Logger::log("restore: loaded " + std::to_string(m_SubGraphs.size()) +
+                " subgraphs in " + std::to_string(stopwatch.getElapsedTime()) +
+                " s");
+    stopwatch.restart();
 
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                Node node;
-                json rows = data["row"];
+    Property macro = {.variable = "isMacro", .value = makeString("true")};
 
-                json properties = rows[0];
+    // rows grouped by label and relation type, nodes and relations shared
+    // by several subgraphs are written once
+    std::map<std::string, json> nodeRows;
+    std::map<std::string, json> relationRows;
+    std::unordered_set<std::string> seenNodes;
+    std::unordered_set<std::string> seenRelations;
 
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
+    for (auto &subgraph : m_SubGraphs) {
+        auto subgraphNodes = subgraph.getNodes();
 
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
+        for (size_t index = 0; index < subgraphNodes.size(); ++index) {
+            Node &node = subgraphNodes[index];
 
-                for (auto &label : rows[1]) {
-                    node.setLabel(label);
-                }
-                nodes.push_back(node);
+            // the first node still exists, it is no macro any more
+            if (index == 0) node.removeProperty(macro);
+
+            if (seenNodes.insert(node.getId()).second)
+                nodeRows[node.getLabel()].push_back(nodeToRow(node));
+
+            for (auto &edge : subgraph.getEdges(index)) {
+                Node &target = subgraphNodes[edge.target];
+
+                // Self loops are not allowed
+                if (node.compare(target)) continue;
+
+                std::string relation =
+                    subgraph.getRelationName(edge.relationId);
+                if (!seenRelations
+                         .insert(node.getId() + relation + target.getId())
+                         .second)
+                    continue;
+
+                relationRows[relation].push_back(
+                    {{"from", node.getId()}, {"to", target.getId()}});
             }
         }
-     }
-
-    for (auto &node : nodes) {
-        AdjacencyMatrix subgraph = getSubgraph(node);
-        node.removeProperty(property);
-        m_SubGraphs.push_back(subgraph);
     }
+
+    // Nodes first, the relations point to them
+    for (auto &rows : nodeRows)
+        m_main->pushBatchedQueries(m_cypher.mergeNodesQuery(rows.first),
+                                   "rows", rows.second);
+
+    for (auto &rows : relationRows)
+        m_main->pushBatchedQueries(m_cypher.mergeRelationsQuery(rows.first),
+                                   "rows", rows.second);
+
+    m_main->sendQueries();
+
+    stopwatch.stop();
+    Logger::log("restore: wrote " + std::to_string(seenNodes.size()) +
+                " nodes and " + std::to_string(seenRelations.size()) +
+                " relations in " + std::to_string(stopwatch.getElapsedTime()) +
+                " s");
 }
 
-void FilterGraph::restore() {
+void FilterGraph::restorePerNode() {
     loadSubgraphs();
     for (auto &subgraph : m_SubGraphs) {
         m_main->appendGraph(subgraph);
     }
-}
\ No newline at end of file
+}
@@ -52,6 +52,7 @@ class FilterGraph : public ManipulateGraph {
     void replace(DatabaseInfo databaseInfo, Node link);
 
     // restores the old state of the main database
+    // (batched statements, one transaction)
     void restore();
 
     void addSubgraph(AdjacencyMatrix subgraph) {
@@ -59,6 +60,15 @@ class FilterGraph : public ManipulateGraph {
     }
 
        private:
+    // sets isMacro on the linked node of every subgraph (link, the first
+    // node if link is nullptr) and deletes the other nodes, all subgraphs
+    // are replaced with a few UNWIND statements in one transaction
+    void replaceSubgraphs(Graph &mainDatabase, const Node *link);
+
+    // per node queries, used for storage backends
+    void replaceSubgraphsPerNode(Graph &mainDatabase, const Node *link);
+    void restorePerNode();
+
 std::unique_ptr<Graph> m_main;
     std::vector<AdjacencyMatrix> m_SubGraphs;
     DatabaseFilter m_filter;
@@ -1,9 +1,34 @@
 #include "Graph.h"
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 const std::string logFile = "graphstep.log";
 
+namespace {
+// databases prepared by this process (host and database name)
+std::mutex preparedMutex;
+std::set<std::string> preparedDatabases;
+}  // namespace
+
+Registry &getSchemaRegistry() {
+    // building the registry creates all entity and type descriptors of the
+    // schema, it is done once per process
+    static Registry registry(SchemaInit);
+    return registry;
+}
+
+const std::string &getSchemaName() {
+    static const std::string schemaName = [] {
+        Registry &registry = getSchemaRegistry();
+        registry.ResetSchemas();
+        return std::string(registry.NextSchema()->Name());
+    }();
+    return schemaName;
+}
+
 Graph::Graph() : m_path("") {
     Logger::initializeLogger(logFile);
 }
@@ -24,64 +49,125 @@ Graph::~Graph() {}
 
 void Graph::initRestInterface(DatabaseInfo databaseInfo) {
     m_databaseInfo = databaseInfo;
-    m_pRest = std::make_unique<RestInterface>();
 
-    m_pRest->setHost(databaseInfo.hostName);
-    m_pRest->setCredentials(databaseInfo.credentials.name,
-                            databaseInfo.credentials.password);
-    m_pRest->setPath("db/" + databaseInfo.databaseName + "/tx/commit/");
+    // in-memory graph, shared by all graphs with the same database name
+    if (databaseInfo.hostName.rfind(MEMORY_HOST, 0) == 0) {
+        m_backend = MemoryGraph::getStore(databaseInfo.databaseName);
+        return;
+    }
+
+    if (databaseInfo.hostName.rfind(BOLT_HOST, 0) == 0) {
+        m_pRest = std::make_unique<BoltInterface>(
+            databaseInfo.hostName, databaseInfo.credentials.name,
+            databaseInfo.credentials.password, databaseInfo.databaseName);
+    } else {
+        auto rest = std::make_unique<RestInterface>();
+
+        rest->setHost(databaseInfo.hostName);
+        rest->setCredentials(databaseInfo.credentials.name,
+                             databaseInfo.credentials.password);
+        rest->setPath("db/" + databaseInfo.databaseName + "/tx/commit/");
+        m_pRest = std::move(rest);
+    }
+
+    // all Id lookups expect the StepEntity label
+    prepareDatabase();
+}
+
+void Graph::prepareDatabase() {
+    // backends index the node ids themselves
+    if (m_backend) return;
+
+    const std::string database =
+        m_databaseInfo.hostName + "/" + m_databaseInfo.databaseName;
+
+    std::lock_guard<std::mutex> lock(preparedMutex);
+    if (preparedDatabases.count(database)) return;
+
+    try {
+        // nodes created before the label existed, one transaction per batch
+        // (the constraint is created afterwards, it only covers labeled
+        // nodes)
+        CypherQuery labelQuery = {
+            .statement = "MATCH (n) WHERE n.Id IS NOT NULL AND NOT n:" +
+                         STEP_ENTITY_LABEL + " WITH n LIMIT $limit SET n:" +
+                         STEP_ENTITY_LABEL + " RETURN count(n) AS count",
+            .parameters = {{"limit", ROWS_PER_STATEMENT}}};
+
+        size_t labeled = 0;
+        while (size_t batch = countResult(sendQuery(labelQuery)))
+            labeled += batch;
+
+        if (labeled > 0)
+            Logger::log("labeled " + std::to_string(labeled) +
+                        " existing nodes with " + STEP_ENTITY_LABEL);
+
+        bool hasConstraint =
+            countResult(sendQuery("SHOW CONSTRAINTS YIELD name "
+                                  "WHERE name = 'step_entity_id' "
+                                  "RETURN count(*) AS count")) > 0;
+
+        if (!hasConstraint) {
+            // e.g. left by older versions of FilterGraph::restore
+            size_t duplicates = countResult(sendQuery(
+                "MATCH (n:" + STEP_ENTITY_LABEL +
+                ") WITH n.Id AS id, count(n) AS nodes WHERE nodes > 1 "
+                "RETURN count(id) AS count"));
+            if (duplicates > 0)
+                throw_database_error(std::to_string(duplicates) +
+                                     " ids are used by several nodes");
+
+            // schema and data changes need separate transactions
+            sendQuery("CREATE CONSTRAINT step_entity_id IF NOT EXISTS FOR (n:" +
+                      STEP_ENTITY_LABEL + ") REQUIRE n.Id IS UNIQUE");
+        }
+    } catch (const DatabaseError &error) {
+        Logger::error("preparing the database " + database + " failed: " +
+                      error.what());
+        throw;
+    }
+
+    preparedDatabases.insert(database);
 }
 
 void Graph::deleteDatabase() {
-    std::string response = "";
-    m_pRest->postRequest(getJsonFromCypher("MATCH (n) DETACH DELETE n"),
-                         response);
+    if (m_backend) return m_backend->clear();
+
+    const std::string cypher = "MATCH (n) DETACH DELETE n";
+    Logger::log("Cypher query: " + cypher);
+
+    QueryResponse response;
+    m_pRest->postRequest({CypherQuery{.statement = cypher}}, response);
 }
 
 void Graph::createGraph(AdjacencyMatrix matrix) {
     auto adjacencyMatrixNodes = matrix.getNodes();
-    auto adjacencyMatrixRelations = matrix.getRelationMatrix();
 
     // Create nodes
-    for (auto &node : adjacencyMatrixNodes)
-        sendQuery(m_cypher.createNodeQuery(node));
+    for (auto &node : adjacencyMatrixNodes) Graph::createNode(node);
+
+    for (auto &node : adjacencyMatrixNodes) node.makeStringProperties();
 
     // Create edges
-    size_t currentNode = 0;
-    for (auto &node : adjacencyMatrixNodes) {
-        size_t currentRelation = 0;
-        for (auto &relation : adjacencyMatrixRelations[currentNode]) {
-            if (!relation.empty()) {
-                // Self loops are not allowed
-                if (!node.compare(adjacencyMatrixNodes[currentRelation])) {
-                    node.makeStringProperties();
-                    adjacencyMatrixNodes[currentRelation]
-                        .makeStringProperties();
-
-                    if (relation.find(";") != std::string::npos) {
-                        // Multiple relations found!
-                        std::vector<std::string> relations =
-                            getListFromStrings(relation);
-                        for (auto &entry : relations)
-                            sendQuery(m_cypher.createRelation(
-                                node, adjacencyMatrixNodes[currentRelation],
-                                entry));
-                    } else
-                        sendQuery(m_cypher.createRelation(
-                            node, adjacencyMatrixNodes[currentRelation],
-                            relation));
-                }
-            }
-            ++currentRelation;
+    for (size_t currentNode = 0; currentNode < adjacencyMatrixNodes.size();
+         ++currentNode) {
+        Node &node = adjacencyMatrixNodes[currentNode];
+        for (auto &edge : matrix.getEdges(currentNode)) {
+            // Self loops are not allowed
+            if (node.compare(adjacencyMatrixNodes[edge.target])) continue;
+
+            Graph::createRelation(node, adjacencyMatrixNodes[edge.target],
+                                  matrix.getRelationName(edge.relationId));
         }
-        ++currentNode;
     }
 }
 
 void Graph::deleteNode(Node node) {
     node.setVariable("a");
     node.makeStringProperties();
-    sendQuery(m_cypher.deleteQuery(node));
+    if (m_backend) return m_backend->deleteNodes(node);
+
+    sendQuery(m_cypher.deleteQueryParameterized(node));
 }
 
 void Graph::deleteSubgraph(AdjacencyMatrix subgraph) {
@@ -90,74 +176,80 @@ void Graph::deleteSubgraph(AdjacencyMatrix subgraph) {
 }
 
 void Graph::createNode(Node node) {
-    sendQuery(m_cypher.createNodeQuery(node));
+    if (m_backend) return m_backend->createNode(node);
+
+    sendQuery(m_cypher.createNodeQueryParameterized(node));
 }
 
 void Graph::createRelation(Node from, Node to, std::string relation) {
-    sendQuery(m_cypher.createRelation(from, to, relation));
+    if (m_backend) return m_backend->createRelation(from, to, relation);
+
+    sendQuery(m_cypher.createRelationParameterized(from, to, relation));
 }
 
 void Graph::modifyNode(Node node, Node modified) {
-    std::string query = m_cypher.modifyNodeQuery(node, modified);
+    if (m_backend) return m_backend->modifyNodes(node, modified);
+
+    CypherQuery query = m_cypher.modifyNodeQueryParameterized(node, modified);
     sendQuery(query);
 }
 
 void Graph::modifyNode(Node node, Property newProperty) {
-    std::string query = m_cypher.modifyNodeQuery(node, newProperty);
+    if (m_backend) return m_backend->replaceProperty(node, newProperty);
+
+    CypherQuery query =
+        m_cypher.modifyNodeQueryParameterized(node, newProperty);
     sendQuery(query);
 }
 
-std::string Graph::getJsonFromCypher(const std::string &cypher) {
-    json jsonStatement;
-    json jsonStatements;
-
-    jsonStatement["statement"] = cypher;
-    jsonStatements["statements"].push_back(jsonStatement);
-
+void Graph::pushQueryToJson(const std::string &cypher) {
     Logger::log("Cypher query: " + cypher);
-
-    return jsonStatements.dump();
+    m_queries.push_back({.statement = cypher});
 }
 
-std::string Graph::cypherListToJson() {
-    json queries;
-    json statement;
-    for (auto &cypher : m_cypherQueries) {
-        statement["statement"] = cypher;
-        queries["statements"].push_back(statement);
-    }
+void Graph::pushQueryToJson(const std::string &cypher,
+                            const json &parameters) {
+    Logger::log("Cypher query: " + cypher);
+    m_queries.push_back({.statement = cypher, .parameters = parameters});
+}
 
-    m_cypherQueries.clear();
-    return queries.dump();
+void Graph::pushQueryToJson(const CypherQuery &query) {
+    pushQueryToJson(query.statement, query.parameters);
 }
 
-std::string Graph::cypherToJson(const std::string &cypher) {
-    json queries;
-    json statement;
+void Graph::pushBatchedQueries(const std::string &statement,
+                               const std::string &key, const json &rows,
+                               const json &parameters,
+                               size_t rowsPerStatement) {
+    // 0 means no limit (like CommitPolicy)
+    if (rowsPerStatement == 0) rowsPerStatement = rows.size();
 
-    statement["statement"] = cypher;
-    queries["statements"].push_back(statement);
+    for (size_t first = 0; first < rows.size(); first += rowsPerStatement) {
+        size_t last = std::min(rows.size(), first + rowsPerStatement);
 
-    return queries.dump();
+        json batchParameters = parameters;
+        batchParameters[key] = json(rows.begin() + first, rows.begin() + last);
+        pushQueryToJson(statement, batchParameters);
+    }
 }
 
-void Graph::pushQueryToJson(const std::string &cypher) {
-    json statement;
+QueryResponse Graph::sendQueries() {
+    QueryResponse response;
 
-    Logger::log("Cypher query: " + cypher);
-    m_cypherQueries.push_back(cypher);
-}
+    if (m_backend) {
+        if (m_queries.empty()) return response;
+        throw_database_error(
+            "cypher queries are not supported by the backend");
+    }
 
-std::string Graph::sendQueries() {
-    std::string response = "";
-    std::string jsonData = cypherListToJson();
+    // the queries are dropped even if the request fails
+    std::vector<CypherQuery> queries = std::move(m_queries);
+    m_queries.clear();
 
-    HttpState state = m_pRest->postRequest(jsonData, response);
+    HttpState state = m_pRest->postRequest(queries, response);
 
     checkResponseForErrors(response);
 
-    // Logger::log("Neo4j response: " + response);
-
     switch (state) {
         case HttpState::HTTP_OK:
         case HttpState::HTTP_NO_CONTENT:
@@ -168,18 +260,25 @@ std::string Graph::sendQueries() {
             break;
     }
 
-    m_queries.clear();
     return response;
 }
 
-std::string Graph::sendQuery(const std::string &cypher) {
-    std::string response = "";
-    Logger::log("Query: " + cypher);
+QueryResponse Graph::sendQuery(const std::string &cypher) {
+    return sendQuery(CypherQuery{.statement = cypher});
+}
 
-        HttpState state = m_pRest->postRequest(cypherToJson(cypher), response);
+QueryResponse Graph::sendQuery(const CypherQuery &query) {
+    QueryResponse response;
 
-    checkResponseForErrors(response);
+    if (m_backend)
+        throw_database_error(
+            "cypher queries are not supported by the backend");
 
+    Logger::log("Query: " + query.statement);
+
+    HttpState state = m_pRest->postRequest({query}, response);
+
+    checkResponseForErrors(response);
 
     switch (state) {
         case HttpState::HTTP_OK:
@@ -212,28 +311,23 @@ vector<std::string> Graph::getEntriesAggregate(std::string str) {
 
 std::vector<std::string> Graph::getAllLabels() {
     // MATCH (n) RETURN distinct labels(n)
+    if (m_backend) return m_backend->getLabels();
+
     std::vector<std::string> labels;
     Node node;
     node.setVariable("n");
 
-    std::string jsonString =
-        sendQuery(m_cypher.matchQuery(node, "distinct labels(n)"));
-
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-                for (auto &row : rows) {
-                    if (!row[0].empty()) labels.push_back(row[0]);
+    ResultDecoder::decode(
+        sendQuery(m_cypher.matchQuery(node, "distinct labels(n)")),
+        [&labels](ResultRow &row) {
+            for (auto &column : row) {
+                for (auto &label : column.entries) {
+                    if (label == STEP_ENTITY_LABEL) continue;
+                    labels.push_back(label);
+                    break;
                 }
             }
-        }
-    }
+        });
 
     std::sort(labels.begin(), labels.end());
     return labels;
@@ -246,26 +340,25 @@ std::vector<std::string> Graph::getNodeIds(std::string label) {
     node.setLabel(label);
     node.setVariable("a");
 
-    std::string jsonString =
-        sendQuery(m_cypher.matchQuery(node, node.getVariable()));
+    if (m_backend) {
+        std::vector<std::string> ids;
+        for (auto &entry : m_backend->matchNodes(node))
+            ids.push_back(entry.getId());
+        return ids;
+    }
+
     std::vector<std::string> entities;
 
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-                for (auto &row : rows) {
-                    std::string fileId = row["Id"];
-                    entities.push_back(fileId);
+    ResultDecoder::decode(
+        sendQuery(m_cypher.matchQuery(node, node.getVariable())),
+        [&entities](ResultRow &row) {
+            for (auto &column : row) {
+                for (auto &property : column.fields) {
+                    if (property.variable == "Id")
+                        entities.push_back(removeQuotation(property.value));
                 }
             }
-        }
-    }
+        });
     return entities;
 }
 
@@ -291,9 +384,12 @@ std::vector<Node> Graph::getTreeNodes(Node parentNode) {
 
     Node from(parentNode.getId());
     from.setVariable("a");
+
+    if (m_backend) return m_backend->getDescendants(from);
     Node to;
     to.setVariable("b");
-    std::string query = m_cypher.matchQuery(from, "*", to, "*, labels(b)");
+    CypherQuery query =
+        m_cypher.matchQueryParameterized(from, "*", to, "*, labels(b)");
 
     treeNodes = jsonToNodeList(sendQuery(query));
     makeNodeListUnique(treeNodes);
@@ -308,61 +404,20 @@ std::vector<std::pair<Node, std::string>> Graph::getChildNodes(
     Node from(parentNode.getId());
     from.setVariable("a");
 
+    if (m_backend) return m_backend->getChildren(from);
+
     Node to;
     to.setVariable("b");
 
-    std::string query =
-        m_cypher.matchQuery(from, "r", to, "b, labels(b), TYPE(r)");
-    std::string jsonString = sendQuery(query);
-
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-
-                //  "row": [
-                //         {
-                //             "name": "",
-                //             "Id": 25
-                //         },
-                //         [
-                //             "Draughting_Model"
-                //         ],
-                //         "rep_2"
-                //     ],
-
-                // row[0] contains json object with properties
-                json properties = rows[0];
-
-                Node node;
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
-
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
-
-                // rows[1] contains the node label
-                // should normally contain only one value
-                for (auto &label : rows[1])  
-                    node.setLabel(label);
-
-                // rows[2] contains the relationship
-                std::string relation = rows[2];
+    CypherQuery query = m_cypher.matchQueryParameterized(
+        from, "r", to, "b, labels(b), TYPE(r)");
 
-                children.push_back(std::make_pair(node, relation));
-            }
-        }
-    }
+    // row: properties of b, labels of b, relation
+    ResultDecoder::decode(sendQuery(query), [this, &children](ResultRow &row) {
+        if (row.size() < 3) return;
+        children.push_back(
+            std::make_pair(resultToNode(row[0], row[1]), row[2].value));
+    });
     return children;
 }
 
@@ -373,47 +428,14 @@ std::vector<Node> Graph::getChildNodeList(Node parentNode)
     Node from(parentNode.getId());
     from.setVariable("a");
 
+    if (m_backend) return getNodesFromList(m_backend->getChildren(from));
+
     Node to;
     to.setVariable("b");
 
-    std::string query =
-        m_cypher.matchQuery(from, "r", to, "b, labels(b)");
-    std::string jsonString = sendQuery(query);
-
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-
-                // row[0] contains json object with properties
-                json properties = rows[0];
-
-                Node node;
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
-
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
-
-                // rows[1] contains the node label
-                // should normally contain only one value
-                for (auto &label : rows[1])  
-                    node.setLabel(label);
-
-                children.push_back(node);
-            }
-        }
-    }
+    CypherQuery query =
+        m_cypher.matchQueryParameterized(from, "r", to, "b, labels(b)");
+    children = jsonToNodeList(sendQuery(query));
     return children;
 }
 
@@ -426,49 +448,11 @@ std::vector<Node> Graph::getAllParents(Node childNode, int depth) {
     childNode.makeStringProperties();
     childNode.setVariable("b");
 
-    std::string query =
-        m_cypher.matchQuery(node, "*", childNode,
-                            node.getVariable() + ", labels(a)");
-    std::string jsonString = sendQuery(query);
-    std::vector<Node> children;
-
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-
-                // row[0] contains json object with properties
-                json properties = rows[0];
-
-                Node node;
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
-
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
-
-                // rows[1] contains the node label
-                // rows[1] is an array but should normally contain only one
-                // value
-                for (auto &label : rows[1]) {
-                    node.setLabel(label);
-                }
+    if (m_backend) return m_backend->getAncestors(childNode);
 
-                children.push_back(node);
-            }
-        }
-    }
-    return children;
+    CypherQuery query = m_cypher.matchQueryParameterized(
+        node, "*", childNode, node.getVariable() + ", labels(a)");
+    return jsonToNodeList(sendQuery(query));
 }
 
 std::vector<Node> Graph::getAllChildren(Node childNode, int depth) {
@@ -477,94 +461,117 @@ std::vector<Node> Graph::getAllChildren(Node childNode, int depth) {
     std::vector<Node> children;
 
     childNode.setVariable("a");
+
+    if (m_backend) {
+        if (depth == -1) return m_backend->getDescendants(childNode);
+        return getNodesFromList(m_backend->getChildren(childNode));
+    }
+
     Node node;
     node.setVariable("b");
-    std::string query;
+    CypherQuery query;
     if(depth == -1){
-        query = m_cypher.matchQuery(
+        query = m_cypher.matchQueryParameterized(
             childNode, "*", node, "b, labels(b)");
     } else {
-        query = m_cypher.matchQuery(
+        query = m_cypher.matchQueryParameterized(
             childNode, m_cypher.depthString("r", 0), node, "b, labels(b), r");
     }
 
-    std::string jsonString = sendQuery(query);
+    children = jsonToNodeList(sendQuery(query));
+    return children;
+}
 
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
+AdjacencyMatrix Graph::getSubgraph(Node node) {
+    AdjacencyMatrix subgraph;
 
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
+    if (m_backend) {
+        subgraph.setNodes(getTreeNodes(node));
+        subgraph.insertNode(node);
 
-                // row[0] contains json object with properties
-                json properties = rows[0];
+        auto subGraphNodes = subgraph.getNodes();
+        subgraph.setRelations(collectRelations(subGraphNodes));
+        return subgraph;
+    }
 
-                Node node;
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
+    // single query: distinct nodes and the relations between them
+    // the given node stays the first node of the subgraph
+    std::vector<Node> nodes = {node};
+    // (relation type, target id) pairs of every node
+    std::vector<std::vector<std::pair<std::string, std::string>>> edges = {{}};
+
+    std::unordered_map<std::string, size_t> nodeIndex;
+    nodeIndex[node.getId()] = 0;
+
+    // row: properties, labels, [relation type, target id] pairs
+    // (pairs keep type and target together, collect drops only whole nulls)
+    ResultDecoder::decode(
+        sendQuery(m_cypher.subgraphQuery(node)), [&](ResultRow &row) {
+            if (row.size() < 3) return;
+
+            Node child = resultToNode(row[0], row[1]);
+            size_t index = 0;
+
+            auto it = nodeIndex.find(child.getId());
+            if (it == nodeIndex.end()) {
+                index = nodes.size();
+                nodeIndex[child.getId()] = index;
+                nodes.push_back(child);
+                edges.emplace_back();
+            } else {
+                index = it->second;
+            }
 
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
+            edges[index].clear();
+            for (auto &entry : row[2].entries) {
+                json pair = json::parse(entry);
 
-                // rows[1] contains the node label
-                // rows[1] is an array but should normally contain only one
-                // value
-                for (auto &label : rows[1]) {
-                    node.setLabel(label);
-                }
+                // no relation (optional match) or target without id
+                if (!pair.is_array() || pair.size() != 2 ||
+                    !pair[0].is_string() || !pair[1].is_string())
+                    continue;
 
-                children.push_back(node);
+                edges[index].emplace_back(pair[0].get<std::string>(),
+                                          pair[1].get<std::string>());
             }
-        }
-    }
-    return children;
-}
+        });
 
-AdjacencyMatrix Graph::getSubgraph(Node node) {
-    AdjacencyMatrix subgraph;
-    std::vector<std::string> row;
-
-    subgraph.setNodes(getTreeNodes(node));
-    subgraph.insertNode(node);
+    std::vector<AdjacencyMatrix::IndexedRelation> relations;
+    for (size_t from = 0; from < nodes.size(); ++from) {
+        for (auto &[type, target] : edges[from]) {
+            auto to = nodeIndex.find(target);
+            if (to == nodeIndex.end()) continue;
 
-    auto subGraphNodes = subgraph.getNodes();
+            relations.push_back(
+                {.from = from, .to = to->second, .relation = type});
+        }
+    }
 
-    for (auto &node : subGraphNodes) node.makeStringProperties();
+    subgraph.setNodes(nodes);
+    subgraph.setRelations(relations);
+    return subgraph;
+}
 
-    for (auto &treeNode : subGraphNodes) {
-        row.clear();
+std::vector<AdjacencyMatrix::IndexedRelation> Graph::collectRelations(
+    std::vector<Node> &nodes) {
+    std::vector<AdjacencyMatrix::IndexedRelation> relations;
 
-        for (auto &temp : subGraphNodes) row.push_back("");
+    // position of the first node with a given id
+    std::unordered_map<std::string, size_t> nodeIndex;
+    for (size_t index = 0; index < nodes.size(); ++index)
+        nodeIndex.emplace(nodes[index].getId(), index);
 
-        auto children = getChildNodes(treeNode);
+    for (size_t from = 0; from < nodes.size(); ++from) {
+        auto children = getChildNodes(nodes[from]);
 
-        // Populate matrix
         for (auto &child : children) {
-            Node childNode = child.first;
-            auto it = std::find_if(
-                subGraphNodes.begin(), subGraphNodes.end(),
-                [&childNode](Node &obj) { return obj.compare(childNode); });
-
-            if (it != subGraphNodes.end()) {
-                auto index = it - subGraphNodes.begin();
-                if (row[index].empty())
-                    row[index] = child.second;
-                else
-                    row[index] += ";" + child.second;
-            }
+            auto it = nodeIndex.find(child.first.getId());
+            if (it != nodeIndex.end())
+                relations.push_back(
+                    {.from = from, .to = it->second, .relation = child.second});
         }
-        subgraph.addRelationRow(row);
     }
-    return subgraph;
+    return relations;
 }
 
 void Graph::appendGraph(AdjacencyMatrix matrix) {
@@ -579,44 +586,14 @@ void Graph::appendGraph(AdjacencyMatrix matrix) {
     modifyNode(matrixNodes[0], modified);
 }
 
-std::vector<Node> Graph::jsonToNodeList(std::string jsonString) {
+std::vector<Node> Graph::jsonToNodeList(QueryResponse response) {
     std::vector<Node> nodes;
 
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                Node node;
-                json rows = data["row"];
-
-                // row[1] contains json object with properties
-                json properties = rows[0];
-
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
-
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
-
-                // rows[2] contains the node label
-                // rows[2] is an array but should normally contain only one
-                // value
-                for (auto &label : rows[1]) {
-                    node.setLabel(label);
-                }
-                nodes.push_back(node);
-            }
-        }
-    }
+    // row: properties, labels
+    ResultDecoder::decode(std::move(response), [this, &nodes](ResultRow &row) {
+        if (row.size() < 2) return;
+        nodes.push_back(resultToNode(row[0], row[1]));
+    });
     return nodes;
 }
 
@@ -624,45 +601,21 @@ Node Graph::getNextNode(Node node, std::string relation) {
     node.setVariable("a");
     node.makeStringProperties();
 
+    if (m_backend) {
+        for (auto &child : m_backend->getChildren(node)) {
+            if (child.second == relation) return child.first;
+        }
+        return Node();
+    }
+
     Node secondNode;
     secondNode.setVariable("b");
 
-    std::string query =
-        m_cypher.matchQuery(node, ":" + relation, secondNode, "b, labels(b)");
-    std::string jsonString = sendQuery(query);
-
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-
-                // row[0] contains json object with properties
-                json properties = rows[0];
-
-                Node node;
-                for (auto &property : properties.items()) {
-                    std::string value =
-                        removeQuotation(property.value().dump());
-
-                    if (property.key() == "Id")
-                        node.setId(value);
-                    else
-                        node.addProperty(
-                            {.variable = property.key(), .value = value});
-                }
-
-                // rows[1] contains the node label
-                node.setLabel(rows[1][0]);
+    CypherQuery query = m_cypher.matchQueryParameterized(
+        node, ":" + relation, secondNode, "b, labels(b)");
+    std::vector<Node> nodes = jsonToNodeList(sendQuery(query));
+    if (!nodes.empty()) return nodes[0];
 
-                return node;
-            }
-        }
-    }
     return Node();
 }
 
@@ -670,53 +623,157 @@ std::vector<Property> Graph::getProperties(Node node) {
     // MATCH (p:Vertex_Point) WHERE p.FileId=83 RETURN p;
     std::vector<Property> properties;
     node.setVariable("a");
-    std::string query = m_cypher.matchQuery(node, "a");
-    std::string jsonString = sendQuery(query);
-
-    if (!jsonString.empty()) {
-        // Parse json
-        json jsonData = json::parse(jsonString);
-        json results = jsonData["results"];
-
-        for (auto &result : results) {
-            json dataList = result["data"];
-            for (auto &data : dataList) {
-                json rows = data["row"];
-                for (auto &row : rows) {
-                    for (auto it = row.begin(); it != row.end(); ++it) {
-                        if (it.key() != "Id") {
-                            std::string value =
-                                removeQuotation(it.value().dump());
-
-                            filterString(value);
-
-                            properties.push_back(
-                                {.variable = it.key(), .value = value});
-                        }
-                    }
-                }
-            }
+
+    if (m_backend) {
+        for (auto &entry : m_backend->matchNodes(node)) {
+            std::vector<Property> nodeProperties = entry.getProperties();
+            properties.insert(properties.end(), nodeProperties.begin(),
+                              nodeProperties.end());
         }
+        sortProperties(properties);
+        return properties;
     }
 
+    CypherQuery query = m_cypher.matchQueryParameterized(node, "a");
+    ResultDecoder::decode(sendQuery(query), [this, &properties](ResultRow &row) {
+        for (auto &column : row) {
+            std::vector<Property> rowProperties = resultToProperties(column);
+            properties.insert(properties.end(), rowProperties.begin(),
+                              rowProperties.end());
+        }
+    });
+
     sortProperties(properties);
     return properties;
 }
 
+std::vector<Node> Graph::matchNodes(Node node) {
+    node.setVariable("a");
+    if (m_backend) return m_backend->matchNodes(node);
+
+    return jsonToNodeList(
+        sendQuery(m_cypher.matchQueryParameterized(node, "a, labels(a)")));
+}
+
+size_t Graph::countNodes() {
+    if (m_backend) return m_backend->countNodes();
+
+    return countResult(sendQuery("MATCH (n) RETURN count(n) AS count"));
+}
+
+size_t Graph::countRelations() {
+    if (m_backend) return m_backend->countRelations();
+
+    return countResult(sendQuery("MATCH ()-[r]->() RETURN count(r) AS count"));
+}
+
+size_t Graph::countResult(QueryResponse response) {
+    size_t count = 0;
+    ResultDecoder::decode(std::move(response), [&count](ResultRow &row) {
+        if (!row.empty() && row[0].type == ResultValue::Type::Scalar)
+            count = std::stoull(row[0].value);
+    });
+    return count;
+}
+
+Node Graph::resultToNode(const ResultValue &properties,
+                         const ResultValue &labels) {
+    Node node;
+    for (auto &property : properties.fields) {
+        std::string value = removeQuotation(property.value);
+
+        if (property.variable == "Id")
+            node.setId(value);
+        else
+            node.addProperty({.variable = property.variable, .value = value});
+    }
+
+    // should normally contain only one label besides StepEntity
+    for (auto &label : labels.entries) {
+        if (label != STEP_ENTITY_LABEL) node.setLabel(label);
+    }
+
+    return node;
+}
+
+std::vector<Property> Graph::resultToProperties(const ResultValue &properties) {
+    std::vector<Property> ret;
+
+    for (auto &property : properties.fields) {
+        if (property.variable != "Id") {
+            std::string value = removeQuotation(property.value);
+
+            filterString(value);
+
+            ret.push_back({.variable = property.variable, .value = value});
+        }
+    }
+    return ret;
+}
+
+std::vector<Node> Graph::getAllNodes() {
+    // MATCH (n) RETURN n.Id, labels(n), properties(n)
+    if (m_backend) return m_backend->getAllNodes();
+
+    std::vector<Node> nodes;
+    // row: id, labels, properties
+    ResultDecoder::decode(
+        sendQuery("MATCH (n) RETURN n.Id, labels(n), properties(n)"),
+        [this, &nodes](ResultRow &row) {
+            if (row.size() < 3 || row[0].type != ResultValue::Type::Scalar)
+                return;
+
+            Node node(row[0].value);
+            for (auto &label : row[1].entries) {
+                if (label != STEP_ENTITY_LABEL) node.setLabel(label);
+            }
+
+            std::vector<Property> properties = resultToProperties(row[2]);
+            sortProperties(properties);
+            node.setProperties(properties);
+
+            nodes.push_back(node);
+        });
+    return nodes;
+}
+
+std::vector<Relation> Graph::getAllRelations() {
+    // MATCH (a)-[r]->(b) RETURN a.Id, TYPE(r), b.Id
+    if (m_backend) return m_backend->getAllRelations();
+
+    std::vector<Relation> relations;
+    // row: start id, type, end id
+    ResultDecoder::decode(
+        sendQuery("MATCH (a)-[r]->(b) RETURN a.Id, TYPE(r), b.Id"),
+        [&relations](ResultRow &row) {
+            if (row.size() < 3 || row[0].type != ResultValue::Type::Scalar ||
+                row[2].type != ResultValue::Type::Scalar)
+                return;
+
+            relations.push_back({.nodeIdFrom = std::move(row[0].value),
+                                 .nodeIdTo = std::move(row[2].value),
+                                 .relation = std::move(row[1].value)});
+        });
+    return relations;
+}
+
 Node Graph::getNode(Node node) {
     node.makeStringProperties();
     node.setVariable("a");
-    std::string jsonString =
-        sendQuery(m_cypher.matchQuery(node, node.getVariable()));
 
-    std::vector<Node> nodes = jsonToNodeList(jsonString);
+    std::vector<Node> nodes;
+    if (m_backend)
+        nodes = m_backend->matchNodes(node);
+    else
+        nodes = jsonToNodeList(sendQuery(
+            m_cypher.matchQueryParameterized(node, node.getVariable())));
 
     if (nodes.empty()) {
         Logger::error("Node not found");
         return Node();
     }
 
-    nodes[0].setLabel(node.getLabel());
+    if (!node.getLabel().empty()) nodes[0].setLabel(node.getLabel());
     return nodes[0];
 }
 
@@ -724,99 +781,44 @@ AdjacencyMatrix Graph::nodesToAdjacencyMatrix(std::vector<Node> nodes) {
     AdjacencyMatrix matrix;
     makeNodeListUnique(nodes);
     matrix.setNodes(nodes);
-    std::vector<std::string> row;
-
-    for (auto &currentNode : nodes) {
-        row.clear();
-
-        std::vector<std::pair<Node, std::string>> children =
-            getChildNodes(currentNode);
-
-        // the other ones are the relations
-        for (auto &node_to : nodes) row.push_back("");
-
-        // Populate matrix
-        for (auto &child : children) {
-            Node childNode = child.first;
-            auto it = std::find_if(
-                nodes.begin(), nodes.end(),
-                [&childNode](Node &obj) { return obj.compare(childNode); });
-
-            if (it != nodes.end()) {
-                // "it" is an iterator to the first matching element
-                auto index = it - nodes.begin();
-                if (row[index].empty())
-                    row[index] = child.second;
-                else
-                    row[index] += ";" + child.second;
-            }
-        }
-        matrix.addRelationRow(row);
-    }
+    matrix.setRelations(collectRelations(nodes));
     return matrix;
 }
 
 bool Graph::loadAdjacencyMatrix() {
+    // Two queries: all nodes (including labels and properties) and all
+    // relations, the matrix is built locally
+    std::vector<Node> nodes = getAllNodes();
 
-    std::vector<std::string> labels = getAllLabels();
-
-    if (labels.empty()) {
+    if (nodes.empty()) {
         Logger::error("Graph is empty");
         return false;
     }
 
-    // Stores all different nodes including their properties
-    std::vector<Node> nodes; 
-    std::vector<std::string> row;
+    std::vector<Relation> relations = getAllRelations();
 
-    for (auto &label : labels) {
-        std::vector<std::string> entries = getNodeIds(label);
-
-        for (auto entry : entries) {
-            Node node(entry);
-            node.setLabel(label);
-
-            std::vector<Property> properties = getProperties(node);
-
-            node.setProperties(properties);
-            m_matrix.addNode(node);
-        }
+    // Position of every node in the matrix
+    std::unordered_map<std::string, size_t> nodeIndex;
+    for (size_t index = 0; index < nodes.size(); ++index) {
+        nodeIndex[nodes[index].getId()] = index;
+        m_matrix.addNode(nodes[index]);
     }
 
-    int currentColumn = 0;
-    auto adjacencyMatrixNodes = m_matrix.getNodes();
-    for (auto &currentNode : adjacencyMatrixNodes) {
-        row.clear();
-
-        std::vector<std::pair<Node, std::string>> children =
-            getChildNodes(currentNode);
+    std::vector<AdjacencyMatrix::IndexedRelation> indexedRelations;
+    indexedRelations.reserve(relations.size());
 
-        // Initialize relations with empty string
-        for (auto &node_to : adjacencyMatrixNodes) row.push_back("");
+    for (auto &relation : relations) {
+        auto from = nodeIndex.find(relation.nodeIdFrom);
+        auto to = nodeIndex.find(relation.nodeIdTo);
+        if (from == nodeIndex.end() || to == nodeIndex.end()) continue;
 
-        // Populate matrix
-        for (auto &child : children) {
-            Node childNode = child.first;
-            auto it = std::find_if(
-                adjacencyMatrixNodes.begin(), adjacencyMatrixNodes.end(),
-                [&childNode](Node &obj) { return obj.compare(childNode); });
-
-            if (it != adjacencyMatrixNodes.end()) {
-                // "it" is an iterator to the first matching element.
-                auto index = it - adjacencyMatrixNodes.begin();
-                if (row[index].empty())
-                    row[index] = child.second;
-                else{
-                    // If more than one relation leads
-                    // to the same node, separate the
-                    // relation strings with semicolons
-                    row[index] += ";" + child.second;  
-                }
-            }
-        }
-        m_matrix.addRelationRow(row);
+        indexedRelations.push_back({.from = from->second,
+                                    .to = to->second,
+                                    .relation = relation.relation});
     }
 
+    m_matrix.setRelations(indexedRelations);
+
     // Marks all nodes that belong to a complex type
     // distinguishes between complex and normal nodes
     m_matrix.markComplexNodes();  
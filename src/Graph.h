@@ -26,15 +26,29 @@ extern void SchemaInit(class Registry &);
 #include <nlohmann/json.hpp>
 
 #include "AdjacencyMatrix.h"
+#include "BoltTools.h"
 #include "CypherParser.h"
 #include "DatabaseError.hpp"
 #include "DerivedStepTypes.h"
+#include "GraphBackend.h"
+#include "MemoryGraph.h"
 #include "RestTools.h"
+#include "ResultDecoder.h"
 #include "Logger.h"
 
+// Registry of the AP242 schema, shared process-wide and built on first use
+// (thread-safe). Entity lookups and ObjCreate may be used concurrently, the
+// schema/entity iterators (NextSchema, NextEntity ...) must not be used.
+Registry &getSchemaRegistry();
+
+// name of the schema contained in the registry
+const std::string &getSchemaName();
+
 /**
  * @brief Graph
  * base class for database manipulations
+ * uses Neo4j (REST) by default, a host name starting with "bolt://" selects
+ * the bolt transport, "memory://" the in-memory backend (MemoryGraph)
 **/
 
 using json = nlohmann::json;
@@ -98,6 +112,9 @@ class Graph {
 
     void initRestInterface(DatabaseInfo databaseInfo);
 
+    // true if a storage backend replaces the server (no cypher queries)
+    bool hasBackend() { return m_backend != nullptr; }
+
     void createGraph(AdjacencyMatrix matrix);
 
     void deleteDatabase();
@@ -111,22 +128,28 @@ class Graph {
 
     void setPath(std::string path) { m_path = path; }
 
-    std::string getJsonFromCypher(const std::string &cypher);
-
     // adds a new statement object to the m_queries vector
     void pushQueryToJson(const std::string &query);
 
-    // converts multiple cypher queries to a json string
-    std::string cypherListToJson();
+    // adds a new statement object with parameters (e.g. $rows) to the
+    // m_queries vector
+    void pushQueryToJson(const std::string &query, const json &parameters);
+    void pushQueryToJson(const CypherQuery &query);
 
-    // converts a single cypher query to a json string
-    std::string cypherToJson(const std::string &cypher);
+    // adds the UNWIND statement once per chunk of rowsPerStatement rows,
+    // each chunk is passed as parameter key (sent with the next sendQueries,
+    // i.e. one transaction)
+    void pushBatchedQueries(const std::string &statement,
+                            const std::string &key, const json &rows,
+                            const json &parameters = json::object(),
+                            size_t rowsPerStatement = ROWS_PER_STATEMENT);
 
     // sends the queries and clears the m_queries vector
-    std::string sendQueries();
+    QueryResponse sendQueries();
 
     // sends a single cypher query
-    std::string sendQuery(const std::string &query);
+    QueryResponse sendQuery(const std::string &query);
+    QueryResponse sendQuery(const CypherQuery &query);
 
     // returns the entries of a aggregate attribute
     std::vector<string> getEntriesAggregate(string str);
@@ -143,6 +166,20 @@ class Graph {
     // returns the property of a node
     std::vector<Property> getProperties(Node node);
 
+    // returns all nodes matching the given node (label, Id, properties)
+    std::vector<Node> matchNodes(Node node);
+
+    size_t countNodes();
+    size_t countRelations();
+
+    // returns all nodes of the graph including labels and properties
+    // (single query)
+    std::vector<Node> getAllNodes();
+
+    // returns all relations of the graph as (start id, type, end id)
+    // (single query)
+    std::vector<Relation> getAllRelations();
+
     // return all underlying nodes (aka. subtree)
     std::vector<Node> getTreeNodes(Node parentNode);
 
@@ -165,11 +202,21 @@ class Graph {
 
     AdjacencyMatrix nodesToAdjacencyMatrix(std::vector<Node> nodes);
 
+    // queries the relations between the given nodes (indices into nodes)
+    std::vector<AdjacencyMatrix::IndexedRelation> collectRelations(
+        std::vector<Node> &nodes);
+
     // append subgraph to existing graph
     void appendGraph(AdjacencyMatrix matrix);
 
-    // json parser functions
-    std::vector<Node> jsonToNodeList(std::string jsonString);
+    // json parser functions (see ResultDecoder)
+    // rows: properties of the node, labels of the node
+    std::vector<Node> jsonToNodeList(QueryResponse response);
+    Node resultToNode(const ResultValue &properties, const ResultValue &labels);
+    std::vector<Property> resultToProperties(const ResultValue &properties);
+
+    // first column of the first row, e.g. RETURN count(n)
+    size_t countResult(QueryResponse response);
 
     // builds the adjacency matrix of the graph
     bool loadAdjacencyMatrix();
@@ -182,17 +229,23 @@ class Graph {
     AdjacencyMatrix getAdjacencyMatrix() { return m_matrix; }
 
    protected:
+    // labels nodes created before the StepEntity label existed (in batches)
+    // and creates the unique index on their Id, done once per database and
+    // process by initRestInterface
+    void prepareDatabase();
+
     // path to stepfile
     std::string m_path;
     
-    // stores all cypher queries
-    std::vector<std::string> m_cypherQueries;
-
     // file to store all cypher queries
     ofstream m_cypherLog;
 
-    // used to exchange data with the server via restapi
-    std::unique_ptr<RestInterface> m_pRest;
+    // used to exchange data with the server (rest api or bolt)
+    std::unique_ptr<Transport> m_pRest;
+
+    // storage backend replacing the server (nullptr: Neo4j is used)
+    // raw cypher queries are not supported by backends
+    std::shared_ptr<GraphBackend> m_backend;
     
     // stores a cypher query
     CypherParser m_cypher;  
@@ -206,6 +259,6 @@ class Graph {
     // object to store all instances/attributes etc. of the .stp file
     InstMgr m_lstInst;  
 
-    // json array, stores multiple statement objects e.g. queries
-    json m_queries;
+    // statements of the next request (sendQueries)
+    std::vector<CypherQuery> m_queries;
 };
\ No newline at end of file
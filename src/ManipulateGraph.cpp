@@ -74,9 +74,9 @@ ManipulateGraph::ManipulateGraph(DatabaseInfo databaseInfo)
 
 ManipulateGraph::~ManipulateGraph() {}
 
-void ManipulateGraph::commitChanges(std::string message) {
+void ManipulateGraph::commitChanges(std::string message, HistoryOptions options) {
     m_trackChanges.setMessage(message);
-    VersionControl control(this->m_databaseInfo);
+    VersionControl control(this->m_databaseInfo, options);
     control.commitBlob(m_trackChanges);
 }
 
@@ -379,27 +379,24 @@ void ManipulateGraph::addNewProductOccurrence(std::string part,
 }
 
 void ManipulateGraph::createNode(Node node) {
-    std::string query = m_cypher.createNodeQuery(node);
     m_trackChanges.addNewNode(node);
-    sendQuery(query);
+    Graph::createNode(node);
 }
 
 void ManipulateGraph::createRelation(Node from, Node to,
                                         std::string relation) {
     m_trackChanges.addNewRelation(from, to, relation);
-    sendQuery(m_cypher.createRelation(from, to, relation));
+    Graph::createRelation(from, to, relation);
 }
 
 void ManipulateGraph::modifyNode(Node node, Node modified) {
-    std::string query = m_cypher.modifyNodeQuery(node, modified);
-
     Modified mod;
     mod.nodeId = node.getId();
     mod.propertyOld = node.getProperties()[0];
     mod.propertyNew = modified.getProperties()[0];
 
     m_trackChanges.addModified(mod);
-    sendQuery(query);
+    Graph::modifyNode(node, modified);
 }
 
 void ManipulateGraph::deletePart(std::string part) {
@@ -492,18 +489,31 @@ Node ManipulateGraph::collectManifoldSolidBrep(std::string part) {
 
         // a:complexNodes[0]-[*]->(b:manifoldSolidBrep) return b
         std::string advancedBrep = "Manifold_Solid_Brep";
-        Node manifoldSolidBrep;
-        manifoldSolidBrep.setVariable("b");
-        manifoldSolidBrep.setLabel(advancedBrep);
-
-        std::string query = m_cypher.matchQuery(complexNodes[0], "*", manifoldSolidBrep, manifoldSolidBrep.getVariable());
-        std::string jsonString = sendQuery(query);
-
-        auto manifoldSolidBrepList = jsonToNodeList(jsonString);
-        manifoldSolidBrep = manifoldSolidBrepList[0];
-        manifoldSolidBrep.setLabel(advancedBrep);
-        
-        return manifoldSolidBrep;
+        std::vector<Node> manifoldSolidBrepList;
+
+        if (m_backend) {
+            // backends have no labeled path match, the descendants are
+            // filtered here
+            manifoldSolidBrepList = getNodesFromList(
+                getAllChildren(complexNodes[0], -1), advancedBrep);
+        } else {
+            Node complexNode(complexNodes[0].getId());
+            complexNode.setVariable("a");
+
+            Node manifoldSolidBrep;
+            manifoldSolidBrep.setVariable("b");
+            manifoldSolidBrep.setLabel(advancedBrep);
+
+            manifoldSolidBrepList = jsonToNodeList(
+                sendQuery(m_cypher.matchQueryParameterized(
+                    complexNode, "*", manifoldSolidBrep,
+                    "b, labels(b) LIMIT 1")));
+        }
+
+        if (manifoldSolidBrepList.empty()) return Node();
+
+        manifoldSolidBrepList[0].setLabel(advancedBrep);
+        return manifoldSolidBrepList[0];
     }
     
     Logger::error("Could not find Shape_Definition_Representation node");
@@ -524,8 +534,5 @@ void ManipulateGraph::addBrep(AdjacencyMatrix matrix, std::string part) {
     createGraph(matrix);
     auto closedShell = matrix.findNodes("Closed_Shell");
     auto manifoldSolidBrep = collectManifoldSolidBrep(part);
-    std::string query = this->m_cypher.createRelation(manifoldSolidBrep,
-                                                      closedShell[0], "outer");
-
-    sendQuery(query);
+    Graph::createRelation(manifoldSolidBrep, closedShell[0], "outer");
 }
\ No newline at end of file
@@ -26,7 +26,8 @@ class ManipulateGraph : public Graph {
     ManipulateGraph(DatabaseInfo databaseInfo);
     ~ManipulateGraph();
 
-    void commitChanges(std::string message);
+    // writes the tracked changes as commit to the history database
+    void commitChanges(std::string message, HistoryOptions options = {});
 
     void createNode(Node node) override;
     void createRelation(Node from, Node to, std::string relation) override;
@@ -24,6 +24,234 @@ NAN_METHOD(EstimateDurationUpload);
 NAN_METHOD(EstimateDurationDownload);
 NAN_METHOD(GetProductHierarchy);
 
+NAN_METHOD(PushFileAsync);
+NAN_METHOD(PullFileAsync);
+NAN_METHOD(AddPartAsync);
+NAN_METHOD(MovePartAsync);
+NAN_METHOD(RotatePartAsync);
+NAN_METHOD(GetProductHierarchyAsync);
+
+/**
+ * @brief PromiseWorker
+ * runs a GraphSTEP operation on the libuv thread pool and settles a
+ * promise with its result. The arguments are read on the main thread,
+ * execute() must not touch any V8 object.
+**/
+class PromiseWorker : public Nan::AsyncWorker {
+   public:
+    PromiseWorker(const char *name) : Nan::AsyncWorker(nullptr, name) {
+        auto resolver =
+            v8::Promise::Resolver::New(Nan::GetCurrentContext())
+                .ToLocalChecked();
+        m_resolver.Reset(resolver);
+    }
+    ~PromiseWorker() { m_resolver.Reset(); }
+
+    v8::Local<v8::Promise> getPromise() {
+        return Nan::New(m_resolver)->GetPromise();
+    }
+
+    // worker thread
+    void Execute() override {
+        try {
+            execute();
+        } catch (const std::exception &e) {
+            SetErrorMessage(e.what());
+        }
+    }
+
+    // main thread
+    void HandleOKCallback() override {
+        Nan::HandleScope scope;
+        Nan::New(m_resolver)
+            ->Resolve(Nan::GetCurrentContext(), result())
+            .ToChecked();
+    }
+
+    void HandleErrorCallback() override {
+        Nan::HandleScope scope;
+        Nan::New(m_resolver)
+            ->Reject(Nan::GetCurrentContext(), Nan::Error(ErrorMessage()))
+            .ToChecked();
+    }
+
+   protected:
+    virtual void execute() = 0;
+    virtual v8::Local<v8::Value> result() = 0;
+
+   private:
+    Nan::Persistent<v8::Promise::Resolver> m_resolver;
+};
+
+// queues the worker and returns its promise to javascript
+void queuePromiseWorker(NAN_METHOD_ARGS_TYPE info, PromiseWorker *worker) {
+    info.GetReturnValue().Set(worker->getPromise());
+    Nan::AsyncQueueWorker(worker);
+}
+
+class PushFileWorker : public PromiseWorker {
+   public:
+    PushFileWorker(std::string path, DatabaseInfo databaseInfo)
+        : PromiseWorker("graphstep:PushFile"),
+          m_path(path),
+          m_databaseInfo(databaseInfo),
+          m_ret(false) {}
+
+   protected:
+    void execute() override {
+        Stopwatch stopwatch;
+
+        // init Graph
+        PushSTEP database(m_path, m_databaseInfo);
+
+        // delete Graph
+        database.deleteDatabase();
+
+        // build Graph
+        m_ret = database.build();
+        if (!m_ret) SetErrorMessage("failed to initialize the database ...");
+
+        stopwatch.stop();
+    }
+
+    v8::Local<v8::Value> result() override { return Nan::New(m_ret); }
+
+   private:
+    std::string m_path;
+    DatabaseInfo m_databaseInfo;
+    bool m_ret;
+};
+
+class PullFileWorker : public PromiseWorker {
+   public:
+    PullFileWorker(std::string outputPath, DatabaseInfo databaseInfo)
+        : PromiseWorker("graphstep:PullFile"),
+          m_outputPath(outputPath),
+          m_databaseInfo(databaseInfo),
+          m_ret(0) {}
+
+   protected:
+    void execute() override {
+        Stopwatch stopwatch;
+
+        PullSTEP database(m_outputPath, m_databaseInfo);
+        m_ret = database.writeStep();
+
+        stopwatch.stop();
+    }
+
+    v8::Local<v8::Value> result() override { return Nan::New(m_ret); }
+
+   private:
+    std::string m_outputPath;
+    DatabaseInfo m_databaseInfo;
+    int m_ret;
+};
+
+class AddPartWorker : public PromiseWorker {
+   public:
+    AddPartWorker(std::string path, std::string part, std::string assembly,
+                  DatabaseInfo databaseInfo)
+        : PromiseWorker("graphstep:AddPart"),
+          m_path(path),
+          m_part(part),
+          m_assembly(assembly),
+          m_databaseInfo(databaseInfo) {}
+
+   protected:
+    void execute() override {
+        Stopwatch stopwatch;
+
+        ManipulateGraph manipulate(m_databaseInfo);
+        manipulate.addNewPart(m_path, m_part, m_assembly);
+
+        stopwatch.stop();
+    }
+
+    v8::Local<v8::Value> result() override { return Nan::True(); }
+
+   private:
+    std::string m_path;
+    std::string m_part;
+    std::string m_assembly;
+    DatabaseInfo m_databaseInfo;
+};
+
+class MovePartWorker : public PromiseWorker {
+   public:
+    MovePartWorker(std::string part, Position position,
+                   DatabaseInfo databaseInfo)
+        : PromiseWorker("graphstep:MovePart"),
+          m_part(part),
+          m_position(position),
+          m_databaseInfo(databaseInfo) {}
+
+   protected:
+    void execute() override {
+        Stopwatch stopwatch;
+
+        ManipulateGraph manipulate(m_databaseInfo);
+        manipulate.movePart(m_part, m_position);
+
+        stopwatch.stop();
+    }
+
+    v8::Local<v8::Value> result() override { return Nan::True(); }
+
+   private:
+    std::string m_part;
+    Position m_position;
+    DatabaseInfo m_databaseInfo;
+};
+
+class RotatePartWorker : public PromiseWorker {
+   public:
+    RotatePartWorker(std::string part, Quaternion quaternion,
+                     DatabaseInfo databaseInfo)
+        : PromiseWorker("graphstep:RotatePart"),
+          m_part(part),
+          m_quaternion(quaternion),
+          m_databaseInfo(databaseInfo) {}
+
+   protected:
+    void execute() override {
+        Stopwatch stopwatch;
+
+        ManipulateGraph manipulate(m_databaseInfo);
+        manipulate.rotatePart(m_part, m_quaternion);
+
+        stopwatch.stop();
+    }
+
+    v8::Local<v8::Value> result() override { return Nan::True(); }
+
+   private:
+    std::string m_part;
+    Quaternion m_quaternion;
+    DatabaseInfo m_databaseInfo;
+};
+
+class ProductHierarchyWorker : public PromiseWorker {
+   public:
+    ProductHierarchyWorker(DatabaseInfo databaseInfo)
+        : PromiseWorker("graphstep:GetProductHierarchy"),
+          m_databaseInfo(databaseInfo) {}
+
+   protected:
+    void execute() override {
+        GraphAnalyser analyser(m_databaseInfo);
+        m_hierarchy = analyser.getProductHierarchyJson();
+    }
+
+    v8::Local<v8::Value> result() override {
+        return Nan::New(m_hierarchy).ToLocalChecked();
+    }
+
+   private:
+    DatabaseInfo m_databaseInfo;
+    std::string m_hierarchy;
+};
+
 NAN_METHOD(ClearDatabase) {
     // Arguments
     // 0: DatabaseInfo (as json string)
@@ -208,6 +436,92 @@ NAN_METHOD(GetProductHierarchy) {
         Nan::New(analyser.getProductHierarchyJson()).ToLocalChecked());
 }
 
+NAN_METHOD(PushFileAsync) {
+    // Arguments
+    // 0: path to step file
+    // 1: DatabaseInfo (as json string)
+    // Returns a promise, rejected if the graph could not be built
+
+    std::string path = *Nan::Utf8String(info[0].As<v8::String>());
+    DatabaseInfo databaseInfo =
+        JsonStringToDatabaseInfo(*Nan::Utf8String(info[1].As<v8::String>()));
+
+    queuePromiseWorker(info, new PushFileWorker(path, databaseInfo));
+}
+
+NAN_METHOD(PullFileAsync) {
+    // Arguments
+    // 0: outputdirectory
+    // 1: DatabaseInfo (as json string)
+    // Returns a promise resolving to the return value of writeStep
+
+    std::string outputPath = *Nan::Utf8String(info[0].As<v8::String>());
+    DatabaseInfo databaseInfo =
+        JsonStringToDatabaseInfo(*Nan::Utf8String(info[1].As<v8::String>()));
+
+    queuePromiseWorker(info, new PullFileWorker(outputPath, databaseInfo));
+}
+
+NAN_METHOD(AddPartAsync) {
+    // Arguments
+    // 0: path of the file to add
+    // 1: part name
+    // 2: assembly name
+    // 3: DatabaseInfo (as json string)
+
+    std::string path = *Nan::Utf8String(info[0].As<v8::String>());
+    std::string part = *Nan::Utf8String(info[1].As<v8::String>());
+    std::string assembly = *Nan::Utf8String(info[2].As<v8::String>());
+    DatabaseInfo databaseInfo =
+        JsonStringToDatabaseInfo(*Nan::Utf8String(info[3].As<v8::String>()));
+
+    queuePromiseWorker(info,
+                       new AddPartWorker(path, part, assembly, databaseInfo));
+}
+
+NAN_METHOD(MovePartAsync) {
+    // Arguments
+    // 0: name of the part to move
+    // 1: new position of the part
+    // 2: DatabaseInfo (as json string)
+
+    std::string part = *Nan::Utf8String(info[0].As<v8::String>());
+    std::string position = *Nan::Utf8String(info[1].As<v8::String>());
+    DatabaseInfo databaseInfo =
+        JsonStringToDatabaseInfo(*Nan::Utf8String(info[2].As<v8::String>()));
+
+    Position pos = stringToPosition(position);
+
+    queuePromiseWorker(info, new MovePartWorker(part, pos, databaseInfo));
+}
+
+NAN_METHOD(RotatePartAsync) {
+    // Arguments
+    // 0: name of the part to rotate
+    // 1: new alignment of the part
+    // 2: DatabaseInfo (as json string)
+
+    std::string part = *Nan::Utf8String(info[0].As<v8::String>());
+    std::string quaternion = *Nan::Utf8String(info[1].As<v8::String>());
+    DatabaseInfo databaseInfo =
+        JsonStringToDatabaseInfo(*Nan::Utf8String(info[2].As<v8::String>()));
+
+    Quaternion quat = stringToQuaternion(quaternion);
+
+    queuePromiseWorker(info, new RotatePartWorker(part, quat, databaseInfo));
+}
+
+NAN_METHOD(GetProductHierarchyAsync) {
+    // Arguments
+    // 0: DatabaseInfo (as json string)
+    // Returns a promise resolving to the hierarchy (as json string)
+
+    DatabaseInfo databaseInfo =
+        JsonStringToDatabaseInfo(*Nan::Utf8String(info[0].As<v8::String>()));
+
+    queuePromiseWorker(info, new ProductHierarchyWorker(databaseInfo));
+}
+
 NAN_MODULE_INIT(InitAll) {
     Set(target, New<String>("clearDatabase").ToLocalChecked(),
         GetFunction(New<FunctionTemplate>(ClearDatabase)).ToLocalChecked());
@@ -238,6 +552,26 @@ NAN_MODULE_INIT(InitAll) {
     Set(target, New<String>("getProductHierarchy").ToLocalChecked(),
         GetFunction(New<FunctionTemplate>(GetProductHierarchy))
             .ToLocalChecked());
+
+    // Promise based variants, executed on the libuv thread pool
+    Set(target, New<String>("pushFileAsync").ToLocalChecked(),
+        GetFunction(New<FunctionTemplate>(PushFileAsync)).ToLocalChecked());
+
+    Set(target, New<String>("pullFileAsync").ToLocalChecked(),
+        GetFunction(New<FunctionTemplate>(PullFileAsync)).ToLocalChecked());
+
+    Set(target, New<String>("addPartAsync").ToLocalChecked(),
+        GetFunction(New<FunctionTemplate>(AddPartAsync)).ToLocalChecked());
+
+    Set(target, New<String>("movePartAsync").ToLocalChecked(),
+        GetFunction(New<FunctionTemplate>(MovePartAsync)).ToLocalChecked());
+
+    Set(target, New<String>("rotatePartAsync").ToLocalChecked(),
+        GetFunction(New<FunctionTemplate>(RotatePartAsync)).ToLocalChecked());
+
+    Set(target, New<String>("getProductHierarchyAsync").ToLocalChecked(),
+        GetFunction(New<FunctionTemplate>(GetProductHierarchyAsync))
+            .ToLocalChecked());
 }
 
 NODE_MODULE(graphstepAddon, InitAll)
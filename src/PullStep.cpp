@@ -1,9 +1,17 @@
 #include "PullStep.h"
 
-PullSTEP::PullSTEP() : Graph(), m_entityCounter(0), m_registry(nullptr) {}
+PullSTEP::PullSTEP()
+    : Graph(),
+      m_entityCounter(0),
+      m_numWorkers(parallelWorkers()),
+      m_registry(&getSchemaRegistry()) {}
 
 PullSTEP::PullSTEP(std::string outputPath, DatabaseInfo databaseInfo)
-    : Graph(databaseInfo), m_entityCounter(0), m_outputPath(outputPath) {}
+    : Graph(databaseInfo),
+      m_outputPath(outputPath),
+      m_entityCounter(0),
+      m_numWorkers(parallelWorkers()),
+      m_registry(&getSchemaRegistry()) {}
 
 PullSTEP::~PullSTEP() {}
 
@@ -25,75 +33,67 @@ std::vector<std::string> PullSTEP::getListEntries(Node listNode) {
     return entries;
 }
 
+std::vector<std::string> PullSTEP::getSelectEntries(Node selectNode) {
+    std::vector<std::string> entries;
+
+    for (int counter = 0;; ++counter) {
+        Node node = m_matrix.getNextNode(selectNode,
+                                         "entry_" + std::to_string(counter));
+        if (node.isEmpty()) break;
+
+        entries.push_back(node.getId());
+    }
+    return entries;
+}
+
+int PullSTEP::findFileId(const std::string &nodeId) const {
+    auto it = fileIdMap.find(nodeId);
+    if (it == fileIdMap.end()) return -1;
+
+    return it->second;
+}
+
 struct find_property_variable : std::unary_function<Property, bool> {
     string variable;
     find_property_variable(string variable) : variable(variable) {}
     bool operator()(Property const &m) const { return m.variable == variable; }
 };
 
-bool PullSTEP::appendEntityAggregate(STEPattribute *attr,
-                                     std::vector<std::string> entries) {
+void PullSTEP::appendEntityAggregate(STEPattribute *attr,
+                                     const std::vector<int> &fileIds) {
     EntityAggregate_ptr aggr = new EntityAggregate();
 
-    for (auto entry : entries) {
-        int fileIdNew = 0;
-        if (fileIdMap.find(entry) != fileIdMap.end()) {
-            fileIdNew = fileIdMap[entry];
-        } else {
-            Logger::error("entity does not exist at the moment ...");
-            return false;
-        }
+    for (int fileId : fileIds)
         aggr->AddNode(
-            new EntityNode(m_instances.GetApplication_instance(fileIdNew)));
-    }
+            new EntityNode(m_instances.GetApplication_instance(fileId)));
 
     attr->Aggregate(aggr);
-    return true;
 }
 
-bool PullSTEP::appendSelectAggregate(STEPattribute *attr,
-                                     std::vector<std::string> entries) {
+void PullSTEP::appendSelectAggregate(STEPattribute *attr,
+                                     const std::vector<int> &fileIds) {
     SelectAggregate_ptr aggr = new SelectAggregate();
 
-    for (auto entry : entries) {
-        int fileIdNew = 0;
-        if (fileIdMap.find(entry) != fileIdMap.end()) {
-            fileIdNew = fileIdMap[entry];
-        } else {
-            Logger::error("entity does not exist at the moment ...");
-            return false;
-        }
-
-        EntitySelect *sel =
-            new EntitySelect((SelectTypeDescriptor *)m_instances
-                                 .GetApplication_instance(fileIdNew)
-                                 ->eDesc,
-                             attr->ReferentType());
-        sel->AssignEntity(m_instances.GetApplication_instance(fileIdNew));
+    for (int fileId : fileIds) {
+        EntitySelect *sel = new EntitySelect(
+            (SelectTypeDescriptor *)m_instances.GetApplication_instance(fileId)
+                ->eDesc,
+            attr->ReferentType());
+        sel->AssignEntity(m_instances.GetApplication_instance(fileId));
 
         aggr->AddNode(new SelectNode(sel));
     }
     attr->Aggregate(aggr);
-    return true;
 }
 
-bool PullSTEP::appendSelectTyped(STEPattribute *attr,
-                                 std::vector<std::string> entries, int fileId,
+void PullSTEP::appendSelectTyped(STEPattribute *attr,
+                                 const std::vector<int> &fileIds, int fileId,
                                  std::string typeName) {
     EntityAggregate_ptr aggr = new EntityAggregate();
 
-    for (auto entry : entries) {
-        int fileIdNew = 0;
-        if (fileIdMap.find(entry) != fileIdMap.end()) {
-            fileIdNew = fileIdMap[entry];
-        } else {
-            Logger::error("entity does not exist at the moment ...");
-            return false;
-        }
-
+    for (int fileIdNew : fileIds)
         aggr->AddNode(
             new EntityNode(m_instances.GetApplication_instance(fileIdNew)));
-    }
 
     TypedSelect *sel =
         new TypedSelect(NULL, attr->aDesc->NonRefTypeDescriptor());
@@ -101,7 +101,6 @@ bool PullSTEP::appendSelectTyped(STEPattribute *attr,
     sel->AssignEntity(m_instances.GetApplication_instance(fileId));
     sel->AddEntityAggregate(aggr);
     attr->ptr.sh = (SDAI_Select *)sel;
-    return true;
 }
 
 void PullSTEP::appendStringAggregate(STEPattribute *attr, std::string aggr) {
@@ -111,42 +110,66 @@ void PullSTEP::appendStringAggregate(STEPattribute *attr, std::string aggr) {
     attr->Aggregate(aggrStr);
 }
 
+bool PullSTEP::findFileIds(const std::vector<std::string> &nodeIds,
+                           std::vector<int> &fileIds,
+                           PopulationLog &log) const {
+    for (auto &nodeId : nodeIds) {
+        int fileId = findFileId(nodeId);
+        if (fileId < 0) {
+            log.push_back({.text = "entity does not exist at the moment ...",
+                           .error = true});
+            return false;
+        }
+        fileIds.push_back(fileId);
+    }
+    return true;
+}
+
+void PullSTEP::writePopulationLog(const PopulationLog &log) {
+    for (auto &message : log) {
+        if (message.error)
+            Logger::error(message.text);
+        else
+            Logger::log(message.text);
+    }
+}
+
 void PullSTEP::populateEntity(STEPentity *ent, Node node) {
-    std::string entityName = ent->EntityName();
-    std::string log = "Populating " + entityName + " which has " +
-                      std::to_string(ent->AttributeCount()) + " attributes.";
-    Logger::log(log);
+    PopulationLog log;
+    ResolvedEntity resolved;
+    resolveEntity(ent, node, resolved, log);
 
-    std::string label = ent->EntityName();
+    writePopulationLog(log);
+    applyAttributes(resolved);
+}
+
+void PullSTEP::resolveEntity(STEPentity *ent, Node node,
+                             ResolvedEntity &resolved, PopulationLog &log) {
+    using Kind = ResolvedAttribute::Kind;
+
+    std::string entityName = ent->EntityName();
+    log.push_back({"Populating " + entityName + " which has " +
+                   std::to_string(ent->AttributeCount()) + " attributes."});
 
     // Return properties of the node == primitive attributes of the entities
     // (INT, STRING, ENUM ...)
     std::vector<Property> properties = m_matrix.findProperties(node);
-    std::vector<std::string> relations = m_matrix.getNodeRelations(node);
-
-    // Relations to the aggregate nodes
-    std::vector<std::string> aggregate_entries;
-
-    // Remove _list_type_ from relations
-    std::string toReplace = "_list_type_";
-    for (auto &relation : relations) {
-        if (relation.find(toReplace) != std::string::npos) {
-            aggregate_entries.push_back(relation);
 
-            relation = relation.substr(0, relation.find(toReplace));
-        }
-    }
-    // Stores the value of the current attribute
-    std::string attrValue = "";
-
-    ent->ResetAttributes();
+    // the attributes are read by index, NextAttribute would move the
+    // iterator of the entity
+    const int numAttributes = ent->AttributeCount();
+    for (int index = 0; index < numAttributes; ++index) {
+        STEPattribute *attr = &ent->attributes[index];
 
-    STEPattribute *attr = ent->NextAttribute();
+        // Stores the value of the current attribute
+        std::string attrValue = "";
 
-    while (attr != 0) {
         // True if the value of an attribute comes from the properties of a node
         bool isProperty = false;
 
+        // Nodes linked through the attribute (ordered aggregate entries)
+        std::vector<Node> targets;
+
         // If the attribute is derived --> set _derive to zero
         // see page 9 of paper:
         //   Design of a C++ Software Library for Implementing EXPRESS: The NIST
@@ -159,8 +182,7 @@ void PullSTEP::populateEntity(STEPentity *ent, Node node) {
         //      "A value of “true” in this field indicates that the value would
         //      be written as an asterisk in a Part 21 file."
         if (attr->IsDerived() && (node.getNodeType() != NodeType::COMPLEX)) {
-            attr->Derive(false);
-            attr = ent->NextAttribute();
+            resolved.push_back({.attr = attr, .kind = Kind::Derived});
             continue;
             // Append the attributes to the subtype! not the supertype!
             // e.g.:
@@ -194,8 +216,8 @@ void PullSTEP::populateEntity(STEPentity *ent, Node node) {
                 throw_database_error("something went wrong");
         }
 
-        Logger::log("Found attribute \"" + stepAttribute + "\" of type \"" +
-                    attrDesc->TypeName() + "\"");
+        log.push_back({"Found attribute \"" + stepAttribute + "\" of type \"" +
+                       attrDesc->TypeName() + "\""});
 
         // Check if attribute specified by the step standard is contained in the
         // neo4j-graph
@@ -207,18 +229,15 @@ void PullSTEP::populateEntity(STEPentity *ent, Node node) {
             isProperty = true;
             attrValue = it->value;
         } else {
-            bool found = false;
-            for (auto &relation_entry : relations) {
-                if (relation_entry.find(stepAttribute) != std::string::npos)
-                    found = true;
-            }
-            if (!found) {
+            targets = m_matrix.findAttributeTargets(node, stepAttribute);
+            if (targets.empty()) {
                 // Attribute not found ... Skip this attribute
-                attr = ent->NextAttribute();
                 continue;
             }
         }
 
+        ResolvedAttribute value{.attr = attr, .kind = Kind::Value};
+
         switch (attrDesc->NonRefType()) {
             case INTEGER_TYPE:
             case REAL_TYPE:
@@ -236,49 +255,34 @@ void PullSTEP::populateEntity(STEPentity *ent, Node node) {
             case SET_TYPE:
             case LIST_TYPE:
             case ARRAY_TYPE: {
+                value.kind = Kind::StringAggregate;
+                value.value = attrValue;
+
                 if (!isProperty) {
                     std::vector<std::string> entries;
-                    std::vector<std::string> aggregate_entries_filtered;
-
-                    for (auto &entry : aggregate_entries) {
-                        if (entry.find(stepAttribute) != std::string::npos)
-                            aggregate_entries_filtered.push_back(entry);
-                    }
-
-                    std::sort(aggregate_entries_filtered.begin(),
-                              aggregate_entries_filtered.end(),
-                              compareIntStrings);
 
-                    for (auto &aggregate : aggregate_entries_filtered) {
-                        Node aggregateNode =
-                            m_matrix.getNextNode(node, aggregate);
+                    for (auto &aggregateNode : targets)
                         entries.push_back(aggregateNode.getId());
-                    }
 
                     switch (attr->BaseType()) {
                         case sdaiINSTANCE:
-                            if (!appendEntityAggregate(attr, entries))
-                                ent->NextAttribute();  // Skip attribute if it
-                                                       // doesn't exist
+                            value.kind = Kind::EntityAggregate;
                             break;
                         case sdaiSELECT:
-                            if (!appendSelectAggregate(attr, entries))
-                                ent->NextAttribute();  // Skip attribute if it
-                                                       // doesn't exist
+                            value.kind = Kind::SelectAggregate;
                             break;
                         default:
                             // No instances, just primitive variables (string,
                             // int, real ...)
-                            appendStringAggregate(attr, attrValue);
                             break;
                     }
-                    entries.clear();
-                } else {
-                    // No instances, just primitive variables (string, int, real
-                    // ...)
-                    appendStringAggregate(attr, attrValue);
+
+                    // Skip attribute if an entry doesn't exist
+                    if (value.kind != Kind::StringAggregate &&
+                        !findFileIds(entries, value.fileIds, log))
+                        continue;
                 }
-                attr = ent->NextAttribute();
+                resolved.push_back(std::move(value));
                 continue;
             } break;
             case SELECT_TYPE: {
@@ -287,86 +291,118 @@ void PullSTEP::populateEntity(STEPentity *ent, Node node) {
                     break;
                 }
 
-                int fileIdNew = 0;
-
                 // Store the original FileID of the next node
-                Node temp = m_matrix.getNextNode(node, stepAttribute);
+                Node temp = targets.front();
 
                 if (temp.getLabel() == "SelectInstance") {
-                    std::vector<std::string> entries;
-                    auto list = getChildNodes(temp);
-                    // std::sort(list.begin(), list.end());
-
-                    for (auto &entry : list)
-                        entries.push_back(entry.first.getId());
-                    Property type = temp.getProperty("type");
-                    appendSelectTyped(attr, entries, fileIdNew, type.value);
-
-                    attr = ent->NextAttribute();
+                    // entries from the matrix (ordered), no database query
+                    value.kind = Kind::SelectTyped;
+                    value.value = temp.getProperty("type").value;
+                    if (findFileIds(getSelectEntries(temp), value.fileIds,
+                                    log))
+                        resolved.push_back(std::move(value));
                     continue;
                 } else {
-                    std::string fileIdOriginal = "";
-                    fileIdOriginal = temp.getId();
+                    std::string fileIdOriginal = temp.getId();
 
                     // Use original FileId to return the new one
-                    if (fileIdMap.find(fileIdOriginal) != fileIdMap.end())
-                        fileIdNew = fileIdMap[fileIdOriginal];
-                    else
+                    int fileIdNew = findFileId(fileIdOriginal);
+                    if (fileIdNew < 0)
                         throw_database_error(
                             "entity does not exist (node id: " +
                             fileIdOriginal + ")");
 
-                    EntitySelect *sel = new EntitySelect(
-                        NULL, attr->aDesc->NonRefTypeDescriptor());
-                    sel->AssignEntity(
-                        m_instances.GetApplication_instance(fileIdNew));
-
-                    // Link the select type with the current attribute
-                    attr->ptr.sh = (SDAI_Select *)sel;
-
-                    attr = ent->NextAttribute();
+                    value.kind = Kind::EntitySelect;
+                    value.fileIds = {fileIdNew};
+                    resolved.push_back(std::move(value));
                     continue;
                 }
             } break;
             case sdaiINSTANCE: {
                 if (isProperty) break;
 
-                int fileIdNew = 0;
-
                 // Store the orginial FileID of the next node
-                std::string fileIdOriginal = "";
-                Node temp = m_matrix.getNextNode(node, stepAttribute);
-                fileIdOriginal = temp.getId();
+                std::string fileIdOriginal = targets.front().getId();
 
                 // use original FileId to return the new one
-                if (fileIdMap.find(fileIdOriginal) != fileIdMap.end())
-                    fileIdNew = fileIdMap[fileIdOriginal];
-                else
+                int fileIdNew = findFileId(fileIdOriginal);
+                if (fileIdNew < 0)
                     throw_database_error("entity does not exist (node id: " +
                                          fileIdOriginal + ")");
 
-                //----------------Link Attribute With
-                // Entity--------------------//
-                attr->ptr.c = new (SDAI_Application_instance *);
-                *(attr->ptr.c) = m_instances.GetApplication_instance(fileIdNew);
-
-                // Skip the StrToVal function
-                attr = ent->NextAttribute();
+                value.kind = Kind::Instance;
+                value.fileIds = {fileIdNew};
+                resolved.push_back(std::move(value));
                 continue;
             } break;
             default:
                 break;
         }
 
-        Logger::log("Read attribute with value: " + attrValue);
+        log.push_back({"Read attribute with value: " + attrValue});
+
+        value.value = attrValue;
+        resolved.push_back(std::move(value));
+    }
+}
+
+void PullSTEP::applyAttributes(ResolvedEntity &resolved) {
+    using Kind = ResolvedAttribute::Kind;
 
-        attr->StrToVal(attrValue.c_str());
-        attrValue.clear();
-        attr = ent->NextAttribute();
+    for (auto &value : resolved) {
+        STEPattribute *attr = value.attr;
+
+        switch (value.kind) {
+            case Kind::Derived:
+                attr->Derive(false);
+                break;
+            case Kind::Value:
+                attr->StrToVal(value.value.c_str());
+                break;
+            case Kind::StringAggregate:
+                appendStringAggregate(attr, value.value);
+                break;
+            case Kind::EntityAggregate:
+                appendEntityAggregate(attr, value.fileIds);
+                break;
+            case Kind::SelectAggregate:
+                appendSelectAggregate(attr, value.fileIds);
+                break;
+            case Kind::SelectTyped:
+                appendSelectTyped(attr, value.fileIds, 0, value.value);
+                break;
+            case Kind::EntitySelect: {
+                EntitySelect *sel = new EntitySelect(
+                    NULL, attr->aDesc->NonRefTypeDescriptor());
+                sel->AssignEntity(
+                    m_instances.GetApplication_instance(value.fileIds.front()));
+
+                // Link the select type with the current attribute
+                attr->ptr.sh = (SDAI_Select *)sel;
+            } break;
+            case Kind::Instance:
+                //----------------Link Attribute With
+                // Entity--------------------//
+                attr->ptr.c = new (SDAI_Application_instance *);
+                *(attr->ptr.c) =
+                    m_instances.GetApplication_instance(value.fileIds.front());
+                break;
+        }
     }
 }
 
 void PullSTEP::populateComplexEntity(STEPcomplex *ent, Node complexNode) {
+    PopulationLog log;
+    ResolvedEntity resolved;
+    resolveComplexEntity(ent, complexNode, resolved, log);
+
+    writePopulationLog(log);
+    applyAttributes(resolved);
+}
+
+void PullSTEP::resolveComplexEntity(STEPcomplex *ent, Node complexNode,
+                                    ResolvedEntity &resolved,
+                                    PopulationLog &log) {
     std::vector<Node> children = m_matrix.findChildren(complexNode);
 
     while (ent) {
@@ -381,14 +417,65 @@ void PullSTEP::populateComplexEntity(STEPcomplex *ent, Node complexNode) {
 
         if (childNode.getId().empty()) {
             // Id not found ... Skip entity
+            ent = ent->sc;
             continue;
         }
 
-        populateEntity(ent, childNode);
+        resolveEntity(ent, childNode, resolved, log);
         ent = ent->sc;
     }
 }
 
+void PullSTEP::populateEntities() {
+    // lookups only read the matrix from here on
+    m_matrix.finalize();
+
+    std::vector<std::pair<std::string, int>> entries(fileIdMap.begin(),
+                                                     fileIdMap.end());
+
+    // instances are looked up before the workers start, the instance list
+    // is not thread safe
+    std::vector<STEPentity *> entities;
+    entities.reserve(entries.size());
+    for (auto &entry : entries)
+        entities.push_back(m_instances.GetApplication_instance(entry.second));
+
+    // the workers only read the matrix, fileIdMap and the attribute
+    // descriptors; values, aggregates and selects are created on this thread
+    const size_t chunkSize = 256;
+    size_t numChunks = (entries.size() + chunkSize - 1) / chunkSize;
+    std::vector<PopulationLog> logs(numChunks);
+    std::vector<ResolvedEntity> resolved(numChunks);
+
+    parallelFor(
+        numChunks,
+        [&](size_t chunk) {
+            size_t last = std::min(entries.size(), (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < last; ++i) {
+                Node node(entries[i].first);
+
+                if (entities[i]->IsComplex()) {
+                    node.setLabel(TYPE_COMPLEX);
+                    resolveComplexEntity((STEPcomplex *)entities[i], node,
+                                         resolved[chunk], logs[chunk]);
+                } else {
+                    node.setLabel(entities[i]->EntityName());
+                    resolveEntity(entities[i], node, resolved[chunk],
+                                  logs[chunk]);
+                }
+            }
+        },
+        m_numWorkers);
+
+    for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+        writePopulationLog(logs[chunk]);
+        applyAttributes(resolved[chunk]);
+
+        // release the chunk early
+        ResolvedEntity().swap(resolved[chunk]);
+    }
+}
+
 bool isIntermediateNode(std::string node) {
     if (node == TYPE_COMPLEX || node == TYPE_LIST || node == "SelectInstance" ||
         node == "null_node")
@@ -400,12 +487,8 @@ bool isIntermediateNode(std::string node) {
 int PullSTEP::writeStep(bool createAdjacencyMatrix) {
     if (createAdjacencyMatrix) loadAdjacencyMatrix();
 
-    m_registry = new Registry(SchemaInit);
     STEPfile *sfile = new STEPfile(*m_registry, m_instances, "", false);
 
-    m_registry->ResetSchemas();
-    m_registry->ResetEntities();
-
     // Build file header
     InstMgr *header_instances = sfile->HeaderInstances();
 
@@ -434,9 +517,7 @@ int PullSTEP::writeStep(bool createAdjacencyMatrix) {
     int num_ents = m_registry->GetEntityCnt();
 
     // Print out what schema we're running through.
-    const SchemaDescriptor *schema = m_registry->NextSchema();
-    std::string schemaName(schema->Name());
-    Logger::log("Building entities in schema " + schemaName);
+    Logger::log("Building entities in schema " + getSchemaName());
 
     auto adjacencyMatrixNodes = m_matrix.getNodes();
     if (adjacencyMatrixNodes.empty()) {
@@ -528,19 +609,7 @@ int PullSTEP::writeStep(bool createAdjacencyMatrix) {
         }
     }
 
-    for (auto &entry : fileIdMap) {
-        STEPentity *entity = m_instances.GetApplication_instance(entry.second);
-
-        Node node(entry.first);
-
-        if (entity->IsComplex()) {
-            node.setLabel(TYPE_COMPLEX);
-            populateComplexEntity((STEPcomplex *)entity, node);
-        } else {
-            node.setLabel(entity->EntityName());
-            populateEntity(entity, node);
-        }
-    }
+    populateEntities();
 
     if (m_outputPath.empty()) {
         Logger::warning("No output path given, using default path");
@@ -553,7 +622,413 @@ int PullSTEP::writeStep(bool createAdjacencyMatrix) {
     sfile->WriteExchangeFile(step_out);
 
     delete (sfile);
-    delete (m_registry);
 
     return 0;
-}
\ No newline at end of file
+}
+namespace {
+// instances per request of writeStepStream
+const int STREAM_PAGE_SIZE = 5000;
+
+// one row per (partial) entity, the partial entities of a complex entity
+// follow each other ordered by their entry number
+// row: instance id, labels of the instance, labels of the (partial) entity,
+// properties, relations [type, target id, target labels, select type,
+// select entries [type, id]]
+// targets that are partial entities are returned with the id of their
+// complex entity, so every reference gets the file id of the complex entity
+const std::string STREAM_QUERY =
+    "MATCH (n:" + STEP_ENTITY_LABEL + ")\n"
+    "WHERE n.Id > $after AND NOT n:SelectInstance AND NOT n:" + TYPE_LIST +
+    " AND NOT n:null_node\n"
+    "  AND NOT EXISTS { MATCH (:" + TYPE_COMPLEX + ")-[:entry]->(n) }\n"
+    "WITH n ORDER BY n.Id LIMIT $limit\n"
+    "OPTIONAL MATCH (n:" + TYPE_COMPLEX + ")-[e:entry]->(s)\n"
+    "WITH n, e, coalesce(s, n) AS p ORDER BY n.Id, e.num\n"
+    "RETURN n.Id, labels(n), labels(p), properties(p),\n"
+    "  [(p)-[r]->(m) WHERE NOT (p:" + TYPE_COMPLEX +
+    " AND type(r) = 'entry') |\n"
+    "    [type(r),\n"
+    "     coalesce(head([(c:" + TYPE_COMPLEX + ")-[:entry]->(m) | c.Id]),\n"
+    "              m.Id),\n"
+    "     labels(m), m.type,\n"
+    "     [(m)-[x]->(y) WHERE m:SelectInstance |\n"
+    "       [type(x),\n"
+    "        coalesce(head([(c:" + TYPE_COMPLEX + ")-[:entry]->(y) | c.Id]),\n"
+    "                 y.Id)]]]]";
+
+// node linked through an attribute
+struct RecordTarget {
+    std::string id;
+    std::string label;
+
+    // SelectInstance: type and the linked entries (ordered)
+    std::string selectType;
+    std::vector<std::pair<int, std::string>> entries;
+};
+
+// a (partial) entity read from the database
+struct RecordEntity {
+    std::string label;
+    std::vector<Property> properties;
+
+    // attribute -> (list position, target), position 0 for single values
+    std::unordered_map<std::string, std::vector<std::pair<int, RecordTarget>>>
+        relations;
+};
+
+std::string labelWithout(const std::vector<std::string> &labels) {
+    for (auto &label : labels)
+        if (label != STEP_ENTITY_LABEL) return label;
+
+    return "";
+}
+
+std::string toUpper(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    return str;
+}
+
+// "items_list_type_3" -> {"items", 3}, "entry_2" (SelectInstance) -> 2
+std::pair<std::string, int> splitAttributeRelation(const std::string &type) {
+    const std::string listType = "_list_type_";
+    size_t pos = type.rfind(listType);
+    if (pos == std::string::npos) return {type, 0};
+
+    std::string index = type.substr(pos + listType.size());
+    if (index.empty() || !std::all_of(index.begin(), index.end(), ::isdigit))
+        return {type, 0};
+
+    return {type.substr(0, pos), std::stoi(index)};
+}
+
+// Part 21 string literal, e.g. it's -> 'it''s' (backslashes are doubled)
+std::string toStepString(const std::string &value) {
+    std::string str = "'";
+    for (char c : value) {
+        if (c == '\'' || c == '\\') str += c;
+        str += c;
+    }
+    return str + "'";
+}
+
+int entryIndex(const std::string &type) {
+    size_t pos = type.rfind('_');
+    if (pos == std::string::npos) return 0;
+
+    std::string index = type.substr(pos + 1);
+    if (index.empty() || !std::all_of(index.begin(), index.end(), ::isdigit))
+        return 0;
+
+    return std::stoi(index);
+}
+
+RecordTarget parseTarget(const json &relation) {
+    RecordTarget target;
+    if (relation[1].is_string()) target.id = relation[1];
+    if (relation[2].is_array())
+        target.label =
+            labelWithout(relation[2].get<std::vector<std::string>>());
+    if (relation[3].is_string()) target.selectType = relation[3];
+
+    for (auto &entry : relation[4]) {
+        if (!entry[1].is_string()) continue;
+        target.entries.push_back({entryIndex(entry[0]), entry[1]});
+    }
+    std::sort(target.entries.begin(), target.entries.end());
+
+    return target;
+}
+}  // namespace
+
+const std::vector<PullSTEP::RecordAttribute> &PullSTEP::getRecordLayout(
+    const std::string &entityName) {
+    auto it = m_recordLayouts.find(entityName);
+    if (it != m_recordLayouts.end()) return it->second;
+
+    if (m_registry->FindEntity(entityName.c_str()) == nullptr)
+        throw_database_error("entity: " + entityName + " was not found");
+
+    std::vector<RecordAttribute> &layout = m_recordLayouts[entityName];
+
+    STEPentity *prototype = m_registry->ObjCreate(entityName.c_str());
+    prototype->ResetAttributes();
+
+    STEPattribute *attr;
+    while ((attr = prototype->NextAttribute()) != nullptr) {
+        // redefining attributes are written through the redefined ones
+        if (attr->aDesc->AttrType() == AttrType_Redefining) continue;
+
+        std::string name = attr->aDesc->Name();
+        name = name.substr(name.find('.') + 1);
+
+        layout.push_back({.name = name,
+                          .type = attr->aDesc->NonRefType()});
+    }
+
+    delete prototype;
+    return layout;
+}
+
+const std::vector<std::vector<PullSTEP::RecordAttribute>> &
+PullSTEP::getComplexLayout(const std::vector<std::string> &entityNames) {
+    auto it = m_complexLayouts.find(entityNames);
+    if (it != m_complexLayouts.end()) return it->second;
+
+    auto &layouts = m_complexLayouts[entityNames];
+
+    // same construction as in writeStep
+    const int s = entityNames.size();
+    const char **names = new const char *[s + 1];
+    names[s] = 0;
+    for (int i = 0; i < s; i++) names[i] = entityNames[i].c_str();
+
+    STEPcomplex *prototype = new STEPcomplex(m_registry, names, 0);
+    delete[] names;
+
+    // the partial entities are ordered like the entries of the complex node
+    for (auto &entityName : entityNames) {
+        std::vector<RecordAttribute> layout;
+
+        for (STEPcomplex *part = prototype->head; part; part = part->sc) {
+            if (toUpper(part->EntityName()) != toUpper(entityName)) continue;
+
+            part->ResetAttributes();
+            STEPattribute *attr;
+            while ((attr = part->NextAttribute()) != nullptr) {
+                if (attr->aDesc->AttrType() == AttrType_Redefining) continue;
+
+                std::string name = attr->aDesc->Name();
+                name = name.substr(name.find('.') + 1);
+
+                layout.push_back({.name = name,
+                                  .type = attr->aDesc->NonRefType()});
+            }
+            break;
+        }
+        layouts.push_back(layout);
+    }
+
+    delete prototype;
+    return layouts;
+}
+
+int PullSTEP::getStreamFileId(const std::string &nodeId) {
+    auto it = m_streamFileIds.find(nodeId);
+    if (it != m_streamFileIds.end()) return it->second;
+
+    int fileId = ++m_entityCounter;
+    m_streamFileIds[nodeId] = fileId;
+    return fileId;
+}
+
+int PullSTEP::writeStepStream() {
+    // the backends do not support the query, they are written in memory
+    if (m_backend) return writeStep();
+
+    if (m_outputPath.empty()) {
+        Logger::warning("No output path given, using default path");
+        m_outputPath = m_databaseInfo.databaseName + "_out.stp";
+    }
+
+    Logger::log("Streaming STEPfile to output file " + m_outputPath);
+
+    std::ofstream out(m_outputPath, std::ios::binary);
+    if (!out) {
+        Logger::error("failed to open " + m_outputPath);
+        return -1;
+    }
+
+    // same header as writeStep
+    out << "ISO-10303-21;\nHEADER;\n"
+        << "FILE_DESCRIPTION((''),'2;1');\n"
+        << "FILE_NAME('" << m_databaseInfo.databaseName
+        << "_out.stp','',(''),(''),'','','');\n"
+        << "FILE_SCHEMA(('AP242_MANAGED_MODEL_BASED_3D_ENGINEERING_MIM_LF "
+           "{ 1 0 10303 442 1 1 4 }'));\n"
+        << "ENDSEC;\nDATA;\n";
+    out.flush();
+
+    m_streamFileIds.clear();
+    m_entityCounter = 0;
+
+    // formats the value of an attribute of a (partial) entity
+    auto formatReference = [this](const RecordTarget &target) {
+        return "#" + std::to_string(getStreamFileId(target.id));
+    };
+
+    auto formatAttribute = [&](const RecordAttribute &attribute,
+                               const RecordEntity &entity) -> std::string {
+        for (auto &property : entity.properties) {
+            if (property.variable != attribute.name) continue;
+
+            std::string value = property.value;
+            switch (attribute.type) {
+                case STRING_TYPE:
+                    return toStepString(value);
+                case ENUM_TYPE:
+                case BOOLEAN_TYPE:
+                case LOGICAL_TYPE:
+                    value = removeQuotation(value);
+                    if (value.empty()) return "$";
+                    if (value.front() != '.') value = "." + value + ".";
+                    return value;
+                case REAL_TYPE:
+                    if (value.find_first_of(".eE") == std::string::npos &&
+                        !value.empty())
+                        value += ".";
+                    return value;
+                case SET_TYPE:
+                case LIST_TYPE:
+                case ARRAY_TYPE:
+                    if (!value.empty() && value.front() != '(')
+                        value = "(" + value + ")";
+                    return value;
+                default:
+                    return value.empty() ? "$" : value;
+            }
+        }
+
+        auto relations = entity.relations.find(attribute.name);
+        if (relations == entity.relations.end() || relations->second.empty())
+            return "$";  // derived attributes too, like writeStep
+
+        auto &targets = relations->second;
+        switch (attribute.type) {
+            case SET_TYPE:
+            case LIST_TYPE:
+            case ARRAY_TYPE: {
+                std::string value = "(";
+                for (size_t i = 0; i < targets.size(); ++i) {
+                    if (i > 0) value += ",";
+                    value += formatReference(targets[i].second);
+                }
+                return value + ")";
+            }
+            default: {
+                const RecordTarget &target = targets.front().second;
+                if (target.label != "SelectInstance")
+                    return formatReference(target);
+
+                // e.g. SET_REPRESENTATION_ITEM((#854,#853))
+                std::string value = removeQuotation(target.selectType) + "((";
+                for (size_t i = 0; i < target.entries.size(); ++i) {
+                    if (i > 0) value += ",";
+                    value += "#" + std::to_string(getStreamFileId(
+                                       target.entries[i].second));
+                }
+                return value + "))";
+            }
+        }
+    };
+
+    // instance of the current rows, written when the next instance starts
+    std::string instanceId;
+    std::string instanceLabel;
+    std::vector<RecordEntity> parts;
+    size_t numInstances = 0;
+
+    auto writeInstance = [&]() {
+        if (instanceId.empty() || parts.empty()) {
+            instanceId.clear();
+            return;
+        }
+
+        std::string record;
+        if (instanceLabel == TYPE_COMPLEX) {
+            // references to the partial entities use the id of the complex
+            // entity (see STREAM_QUERY)
+            int fileId = getStreamFileId(instanceId);
+
+            std::vector<std::string> names;
+            for (auto &part : parts) names.push_back(part.label);
+            auto &layouts = getComplexLayout(names);
+
+            record = "#" + std::to_string(fileId) + "=(";
+            for (size_t i = 0; i < parts.size(); ++i) {
+                record += toUpper(parts[i].label) + "(";
+                for (size_t j = 0; j < layouts[i].size(); ++j) {
+                    if (j > 0) record += ",";
+                    record += formatAttribute(layouts[i][j], parts[i]);
+                }
+                record += ")";
+            }
+            record += ");\n";
+        } else {
+            auto &layout = getRecordLayout(instanceLabel);
+
+            record = "#" + std::to_string(getStreamFileId(instanceId)) + "=" +
+                     toUpper(instanceLabel) + "(";
+            for (size_t j = 0; j < layout.size(); ++j) {
+                if (j > 0) record += ",";
+                record += formatAttribute(layout[j], parts.front());
+            }
+            record += ");\n";
+        }
+
+        out << record;
+        ++numInstances;
+
+        instanceId.clear();
+        parts.clear();
+    };
+
+    std::string after = "";
+    for (;;) {
+        CypherQuery query = {
+            .statement = STREAM_QUERY,
+            .parameters = {{"after", after}, {"limit", STREAM_PAGE_SIZE}}};
+
+        size_t numRows = 0;
+        ResultDecoder::decode(sendQuery(query), [&](ResultRow &row) {
+            if (row.size() < 5 || row[0].type != ResultValue::Type::Scalar)
+                return;
+            ++numRows;
+
+            if (row[0].value != instanceId) {
+                writeInstance();
+                instanceId = row[0].value;
+                instanceLabel = labelWithout(row[1].entries);
+                after = instanceId;
+            }
+
+            RecordEntity entity;
+            entity.label = labelWithout(row[2].entries);
+            entity.properties = resultToProperties(row[3]);
+
+            for (auto &entry : row[4].entries) {
+                json relation = json::parse(entry);
+                if (!relation.is_array() || relation.size() < 5 ||
+                    !relation[0].is_string())
+                    continue;
+
+                auto [attribute, index] = splitAttributeRelation(relation[0]);
+                entity.relations[attribute].push_back(
+                    {index, parseTarget(relation)});
+            }
+            for (auto &relations : entity.relations)
+                std::sort(relations.second.begin(), relations.second.end(),
+                          [](auto &lhs, auto &rhs) {
+                              return lhs.first < rhs.first;
+                          });
+
+            // complex node without partial entities
+            if (entity.label == TYPE_COMPLEX) return;
+
+            parts.push_back(std::move(entity));
+        });
+
+        // every page ends with a complete instance
+        writeInstance();
+        out.flush();
+
+        if (numRows == 0) break;
+    }
+
+    out << "ENDSEC;\nEND-ISO-10303-21;\n";
+    out.close();
+
+    Logger::log("Wrote " + std::to_string(numInstances) + " instances to " +
+                m_outputPath);
+    return out.fail() ? -1 : 0;
+}
@@ -2,7 +2,10 @@
 
 #include <SdaiHeaderSchema.h>
 
+#include <unordered_map>
+
 #include "Graph.h"
+#include "ParallelFor.hpp"
 #include "Tools.hpp"
 #include "TypesNeo4j.h"
 
@@ -28,9 +31,88 @@ class PullSTEP : public Graph {
     void populateComplexEntity(STEPcomplex *ent, Node complexNode);
     int writeStep(bool createAdjacencyMatrix = true);
 
+    // Writes the step file while the instances are read from the database
+    // (page by page), no STEPcode instances and no adjacency matrix are
+    // built. File ids are assigned on the fly, the schema only provides the
+    // order of the attributes
+    int writeStepStream();
+
+    // number of threads populating the entities (default: hardware threads)
+    void setNumWorkers(size_t numWorkers) { m_numWorkers = numWorkers; }
+
     std::vector<std::string> getListEntries(Node listNode);
 
    private:
+    // attribute of an entity in the order of the Part 21 record
+    struct RecordAttribute {
+        std::string name;  // without supertype (e.g. "name")
+        BASE_TYPE type;
+    };
+
+    // attributes of an entity, or of the partial entities of a complex
+    // entity (given by their names), built from prototypes of the schema
+    const std::vector<RecordAttribute> &getRecordLayout(
+        const std::string &entityName);
+    const std::vector<std::vector<RecordAttribute>> &getComplexLayout(
+        const std::vector<std::string> &entityNames);
+
+    // file id of a node in the streamed file, assigned on first use
+    int getStreamFileId(const std::string &nodeId);
+
+    // log messages of the population, collected per chunk of entities and
+    // written in entity order (the population runs in parallel)
+    struct PopulationMessage {
+        std::string text;
+        bool error = false;  // written with Logger::error
+    };
+    using PopulationLog = std::vector<PopulationMessage>;
+
+    // value of an attribute found in the matrix, resolved by the workers and
+    // assigned to the STEPcode attribute on one thread (applyAttributes)
+    struct ResolvedAttribute {
+        enum class Kind {
+            Derived,
+            Value,  // StrToVal
+            StringAggregate,
+            EntityAggregate,
+            SelectAggregate,
+            SelectTyped,
+            EntitySelect,
+            Instance
+        };
+
+        STEPattribute *attr;
+        Kind kind;
+        std::string value;         // text, SelectTyped: type name
+        std::vector<int> fileIds;  // linked instances (ordered)
+    };
+    using ResolvedEntity = std::vector<ResolvedAttribute>;
+
+    // reads the matrix, fileIdMap and the attribute descriptors only
+    void resolveEntity(STEPentity *ent, Node node, ResolvedEntity &resolved,
+                       PopulationLog &log);
+    void resolveComplexEntity(STEPcomplex *ent, Node complexNode,
+                              ResolvedEntity &resolved, PopulationLog &log);
+
+    // creates the STEPcode values of the resolved attributes
+    void applyAttributes(ResolvedEntity &resolved);
+
+    void writePopulationLog(const PopulationLog &log);
+
+    // resolves the attributes of all entities of fileIdMap in parallel and
+    // applies them in entity order
+    void populateEntities();
+
+    // ids of the nodes linked to a SelectInstance node (entry_0, entry_1 ...)
+    std::vector<std::string> getSelectEntries(Node selectNode);
+
+    // new file id of a node, -1 if there is none
+    int findFileId(const std::string &nodeId) const;
+
+    // file ids of the nodes, false (and an error in the log) if one is missing
+    bool findFileIds(const std::vector<std::string> &nodeIds,
+                     std::vector<int> &fileIds, PopulationLog &log) const;
+
     // path to the generated step file
     std::string m_outputPath;
 
@@ -46,15 +128,25 @@ class PullSTEP : public Graph {
     // Final order of step entities
     InstMgr m_instances;
 
-    // Registry pointer used to get some information about an entity
+    // writeStepStream: node id -> file id, attribute layouts by entity name
+    std::unordered_map<std::string, int> m_streamFileIds;
+    std::unordered_map<std::string, std::vector<RecordAttribute>>
+        m_recordLayouts;
+    std::map<std::vector<std::string>,
+             std::vector<std::vector<RecordAttribute>>>
+        m_complexLayouts;
+
+    size_t m_numWorkers;
+
+    // Registry used to get some information about an entity
+    // (shared, see getSchemaRegistry)
     Registry *m_registry;
 
     void appendStringAggregate(STEPattribute *attr, std::string aggr);
-    bool appendSelectAggregate(STEPattribute *attr,
-                               std::vector<std::string> entries);
-    bool appendSelectTyped(STEPattribute *attr,
-                           std::vector<std::string> entries, int fileId,
-                           std::string typedName);
-    bool appendEntityAggregate(STEPattribute *attr,
-                               std::vector<std::string> entries);
+    void appendSelectAggregate(STEPattribute *attr,
+                               const std::vector<int> &fileIds);
+    void appendSelectTyped(STEPattribute *attr, const std::vector<int> &fileIds,
+                           int fileId, std::string typedName);
+    void appendEntityAggregate(STEPattribute *attr,
+                               const std::vector<int> &fileIds);
 };
\ No newline at end of file
@@ -1,38 +1,171 @@
 #include "PushStep.h"
 
-PushSTEP::PushSTEP() : Graph(), m_filePath(""), m_fileName("") {}
+#include <charconv>
+
+// target of references that could not be resolved
+const EntityRef NO_ENTITY;
+
+PushSTEP::PushSTEP()
+    : Graph(),
+      m_filePath(""),
+      m_fileName(""),
+      m_isFileRead(false),
+      m_bulkIngest(true),
+      m_numWorkers(parallelWorkers()) {}
 
 PushSTEP::PushSTEP(std::string path, DatabaseInfo databaseInfo)
-    : Graph(path, databaseInfo) {
+    : Graph(path, databaseInfo),
+      m_isFileRead(false),
+      m_bulkIngest(true),
+      m_numWorkers(parallelWorkers()) {
+    m_filePath = path;
+    m_fileName = std::filesystem::path(path).stem();
+}
+
+PushSTEP::PushSTEP(std::string path)
+    : Graph(),
+      m_isFileRead(false),
+      m_bulkIngest(true),
+      m_numWorkers(parallelWorkers()) {
+    setPath(path);
     m_filePath = path;
     m_fileName = std::filesystem::path(path).stem();
 }
 
 PushSTEP::~PushSTEP() {}
 
-void PushSTEP::commitChanges(std::string message) {
+void PushSTEP::commitChanges(std::string message, HistoryOptions options) {
     m_trackChanges.setMessage(message);
-    VersionControl control(this->m_databaseInfo);
+    VersionControl control(this->m_databaseInfo, options);
     control.commitBlob(m_trackChanges);
 }
 
 void PushSTEP::createNode(Node node) {
-    std::string query = m_cypher.createNodeQuery(node);
+    if (m_csvWriter) return m_csvWriter->writeNode(node);
+
     this->m_trackChanges.addNewNode(node);
-    pushQueryToJson(query);
+
+    // backends are written directly, batching only saves server round trips
+    if (m_backend) return Graph::createNode(node);
+
+    ++m_numNodes;
+
+    // rough size of the node in the request (keys, values, quotes)
+    m_pendingBytes += node.getId().size() + node.getLabel().size() + 32;
+    for (auto &property : node.getProperties())
+        m_pendingBytes += property.variable.size() + property.value.size() + 8;
+
+    if (!m_bulkIngest || node.getLabel().empty()) {
+        pushQueryToJson(m_cypher.createNodeQueryParameterized(node));
+        commitIfFull();
+        return;
+    }
+
+    json row;
+    row["Id"] = node.getId();
+    for (auto &property : node.getProperties())
+        row[property.variable] = cypherStringToValue(property.value);
+
+    json &rows = m_nodeBatches[node.getLabel()];
+    rows.push_back(row);
+
+    if (m_commitPolicy.rowsPerStatement &&
+        rows.size() >= m_commitPolicy.rowsPerStatement)
+        flushBatches();
+
+    commitIfFull();
 }
 
 void PushSTEP::createRelation(Node from, Node to, std::string relation) {
+    // unresolved reference (NO_ENTITY), neo4j-admin import aborts on empty
+    // ids and the cypher statements would not match any node
+    if (from.getId().empty() || to.getId().empty()) {
+        Logger::warning("relation " + relation + " skipped, " +
+                        (from.getId().empty() ? "source" : "target") +
+                        " entity not found");
+        return;
+    }
+
+    if (m_csvWriter)
+        return m_csvWriter->writeRelation(from.getId(), to.getId(), relation);
+
     this->m_trackChanges.addNewRelation(from, to, relation);
-    pushQueryToJson(m_cypher.createRelation(from, to, relation));
+
+    if (m_backend) return Graph::createRelation(from, to, relation);
+
+    ++m_numRelations;
+    m_pendingBytes +=
+        from.getId().size() + to.getId().size() + relation.size() + 32;
+
+    if (!m_bulkIngest) {
+        pushQueryToJson(
+            m_cypher.createRelationParameterized(from, to, relation));
+        commitIfFull();
+        return;
+    }
+
+    json &rows = m_relationBatches[relation];
+    rows.push_back({{"from", from.getId()}, {"to", to.getId()}});
+
+    // all groups are flushed, the relations may point to queued nodes
+    if (m_commitPolicy.rowsPerStatement &&
+        rows.size() >= m_commitPolicy.rowsPerStatement)
+        flushBatches();
+
+    commitIfFull();
+}
+
+void PushSTEP::flushBatches() {
+    // Nodes first, relations of the same flush may point to them
+    for (auto &batch : m_nodeBatches)
+        if (!batch.second.empty())
+            pushQueryToJson(m_cypher.createNodesQuery(batch.first),
+                            {{"rows", batch.second}});
+
+    for (auto &batch : m_relationBatches)
+        if (!batch.second.empty())
+            pushQueryToJson(m_cypher.createRelationsQuery(batch.first),
+                            {{"rows", batch.second}});
+
+    m_nodeBatches.clear();
+    m_relationBatches.clear();
+}
+
+void PushSTEP::commitIfFull() {
+    bool full = (m_commitPolicy.maxStatements &&
+                 m_queries.size() >= m_commitPolicy.maxStatements) ||
+                (m_commitPolicy.maxBytes &&
+                 m_pendingBytes >= m_commitPolicy.maxBytes);
+
+    if (full) commitPending();
+}
+
+void PushSTEP::commitPending() {
+    flushBatches();
+    if (m_queries.empty()) return;
+
+    size_t numStatements = m_queries.size();
+    size_t numBytes = m_pendingBytes;
+
+    // every request is committed on its own (independent transactions)
+    sendQueries();
+    m_pendingBytes = 0;
+    ++m_numCommits;
+
+    Logger::log("commit " + std::to_string(m_numCommits) + ": " +
+                std::to_string(numStatements) + " statements (~" +
+                std::to_string(numBytes / 1024) + " KB), " +
+                std::to_string(m_numNodes) + " nodes and " +
+                std::to_string(m_numRelations) + " relations so far");
 }
 
 bool PushSTEP::build() {
     if (createInstanceNodes()) {
-        sendQueries();
+        // all nodes exist before the first relation is sent
+        commitPending();
         Logger::log("queries for the nodes created");
         if (createRelations()) {
-            sendQueries();
+            commitPending();
             Logger::log("queries for the relations created");
         } else {
             Logger::error("failed to create the queries for the relations");
@@ -46,71 +179,180 @@ bool PushSTEP::build() {
     return true;
 }
 
-bool PushSTEP::createInstanceNodes() {
-    Registry registry(SchemaInit);
-    STEPfile stepFile(registry, m_lstInst, "", false);
+bool PushSTEP::exportImportCsv(const std::string &directory) {
+    m_csvWriter = std::make_unique<ImportCsvWriter>(directory);
+
+    // the relations are written after all nodes like in build()
+    bool success = createInstanceNodes() && createRelations();
+    if (success) {
+        m_csvWriter->finish();
+        Logger::log("exported " + std::to_string(m_csvWriter->getNumNodes()) +
+                    " nodes and " +
+                    std::to_string(m_csvWriter->getNumRelations()) +
+                    " relations to " + directory);
+        Logger::log("import: neo4j-admin database import full " +
+                    m_csvWriter->importArguments() + " <database>");
+    } else {
+        Logger::error("failed to export " + m_path);
+    }
+
+    m_csvWriter.reset();
+    return success;
+}
+
+bool PushSTEP::readStepFile() {
+    if (m_isFileRead) return true;
+
+    STEPfile stepFile(getSchemaRegistry(), m_lstInst, "", false);
     stepFile.ReadExchangeFile(m_path);
 
-    // Number of instances
-    int numInst = m_lstInst.InstanceCount();
+    if (m_lstInst.InstanceCount() == 0) {
+        Logger::error("no instances found in " + m_path);
+        return false;
+    }
+
+    Logger::log("read " + std::to_string(m_lstInst.InstanceCount()) +
+                " instances from " + m_path);
 
-    // Id of the according entity (e.g #11= ...)
-    int entityId = 0;
+    m_isFileRead = true;
+    return true;
+}
+
+bool PushSTEP::createInstanceNodes() {
+    if (!readStepFile()) return false;
+
+    // the extraction threads write the references of their own instances
+    int maxFileId = 0;
+    for (int i = 0; i < m_lstInst.InstanceCount(); ++i) {
+        maxFileId =
+            std::max(maxFileId, m_lstInst.GetSTEPentity(i)->StepFileId());
+    }
+
+    m_entityRefs.assign(maxFileId + 1, EntityRef());
+    m_complexRefs.assign(maxFileId + 1, {});
+
+    extractInstances([this](size_t first, size_t last,
+                            ExtractionBuffer &buffer) {
+        extractNodes(first, last, buffer);
+    });
+    return true;
+}
+
+void PushSTEP::extractInstances(
+    const std::function<void(size_t, size_t, ExtractionBuffer &)> &extract) {
+    // instances per task, small enough to balance the workers
+    const size_t chunkSize = 256;
+
+    size_t numInst = m_lstInst.InstanceCount();
+    size_t numChunks = (numInst + chunkSize - 1) / chunkSize;
+
+    // chunks extracted at a time, the buffers of a window are merged (and
+    // committed when the commit policy is reached) before the next window
+    // starts, so only a window of the graph is held in memory
+    const size_t windowSize = std::max<size_t>(1, m_numWorkers) * 4;
+
+    std::vector<ExtractionBuffer> buffers;
+    for (size_t window = 0; window < numChunks; window += windowSize) {
+        size_t numWindowChunks = std::min(windowSize, numChunks - window);
+        buffers.assign(numWindowChunks, ExtractionBuffer());
+
+        parallelFor(
+            numWindowChunks,
+            [&](size_t index) {
+                size_t first = (window + index) * chunkSize;
+                extract(first, std::min(first + chunkSize, numInst),
+                        buffers[index]);
+            },
+            m_numWorkers);
+
+        // merge: same order of statements as a sequential run, the nodes of
+        // a chunk are created before its relations
+        for (auto &buffer : buffers) {
+            for (auto &node : buffer.nodes) createNode(node);
+
+            for (auto &relation : buffer.relations) {
+                Node from(relation.from->id);
+                from.setLabel(relation.from->label);
+                Node to(relation.to->id);
+                to.setLabel(relation.to->label);
+
+                createRelation(from, to, relation.relation);
+            }
+        }
+    }
+}
 
-    for (int i = 0; i < numInst; ++i) {
+void PushSTEP::extractNodes(size_t first, size_t last,
+                            ExtractionBuffer &buffer) {
+    for (size_t i = first; i < last; ++i) {
         // Current instance
         SDAI_Application_instance_ptr pInstance = m_lstInst.GetSTEPentity(i);
 
         // Name of current entity
-        m_entity.name = pInstance->EntityName();
+        std::string entityName = pInstance->EntityName();
 
         // Id of the according entity (e.g #11= ...)
-        m_entity.fileId = std::to_string(pInstance->StepFileId());
+        int fileId = pInstance->StepFileId();
 
         // Add entity id to node to link the correct nodes to each other
-        Node nodeInstance(m_entity.fileId);
-        nodeInstance.setLabel(m_entity.name);
+        Node nodeInstance(std::to_string(fileId));
+        nodeInstance.setLabel(entityName);
 
         // Check complex entity (e.g.
         // "#3=(NAMED_UNIT(*)PLANE_ANGLE_UNIT()SI_UNIT($,.RADIAN.));")
         if (pInstance->IsComplex()) {
             STEPcomplex* pInstComplex = (STEPcomplex*)pInstance;
-            std::string entityName = "";
+            std::vector<EntityRef> &refs = m_complexRefs[fileId];
 
             /* ----- Create COMPLEX_TYPE node ---------------------------*/
-            Node complex_node(m_entity.fileId);
+            Node complex_node(std::to_string(fileId));
             complex_node.setLabel(TYPE_COMPLEX);
             complex_node.createId();
-            m_nodeIdMap[m_entity.fileId] = complex_node;
-            createNode(complex_node);
+            refs.push_back({complex_node.getId(), TYPE_COMPLEX});
+            buffer.nodes.push_back(complex_node);
 
             /* ----- Create COMPLEX_TYPE subnodes ---------------------------*/
             while (pInstComplex != nullptr) {
                 SDAI_Application_instance_ptr compInst =
                     (SDAI_Application_instance_ptr)pInstComplex;
-                m_entity.name = compInst->EntityName();
-                m_entity.fileId = std::to_string(pInstance->StepFileId());
+                std::string subName = compInst->EntityName();
 
                 // Entity id of the subnode is the same as the parents one
-                Node node(m_entity.fileId);
-                node.setLabel(m_entity.name);
+                Node node(std::to_string(fileId));
+                node.setLabel(subName);
 
                 getAttributesForNodes(compInst, node);
                 node.createId();
-                m_nodeIdMap[m_entity.fileId + m_entity.name] = node;
-                createNode(node);
+                refs.push_back({node.getId(), subName});
+                if (subName == entityName) m_entityRefs[fileId] = refs.back();
+                buffer.nodes.push_back(node);
 
                 pInstComplex = pInstComplex->sc;
             }
         } else {
             getAttributesForNodes(pInstance, nodeInstance);
             nodeInstance.createId();
-            m_nodeIdMap[m_entity.fileId + m_entity.name] = nodeInstance;
-            createNode(nodeInstance);
+            m_entityRefs[fileId] = {nodeInstance.getId(), entityName};
+            buffer.nodes.push_back(nodeInstance);
         }
     }
+}
 
-    return true;
+const EntityRef &PushSTEP::findEntity(std::string_view reference) const {
+    // Deletes null-terminator
+    reference = reference.substr(0, reference.find('\0'));
+
+    if (reference.size() < 2 || reference[0] != '#') return NO_ENTITY;
+
+    int fileId = 0;
+    const char *end = reference.data() + reference.size();
+    auto [ptr, ec] = std::from_chars(reference.data() + 1, end, fileId);
+
+    if (ec != std::errc() || ptr != end || fileId < 0 ||
+        size_t(fileId) >= m_entityRefs.size())
+        return NO_ENTITY;
+
+    return m_entityRefs[fileId];
 }
 
 void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
@@ -161,6 +403,9 @@ void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
                 throw_database_error("something went wrong");
         }
 
+        // asStr() creates a new string on every call
+        std::string value = attr->asStr();
+
         switch (attrType) {
             // TYPE == PRIMITVE
             case sdaiSTRING: {
@@ -168,12 +413,12 @@ void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
                 // --> no need to call makeString()
                 Property property;
                 property.variable = attrName;
-                if (attr->asStr().empty())
-                    property.value = makeString(attr->asStr());
-                else if (attr->asStr() == "*")
-                    property.value = makeString(attr->asStr());
+                if (value.empty())
+                    property.value = makeString(value);
+                else if (value == "*")
+                    property.value = makeString(value);
                 else
-                    property.value = attr->asStr();
+                    property.value = value;
 
                 node.addProperty(property);
             } break;
@@ -184,9 +429,9 @@ void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
             case sdaiLOGICAL: {
                 // Push properties to the node if the attribute type is a
                 // std::string, integer or any other "basic" datatype
-                if (!attr->asStr().empty()) {
+                if (!value.empty()) {
                     Property property = {.variable = attrName,
-                                         .value = makeString(attr->asStr())};
+                                         .value = makeString(value)};
                     node.addProperty(property);
                 }
             } break;
@@ -200,13 +445,12 @@ void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
                     node.addProperty(property);
                     continue;
                 }
-                std::string attribute = attr->asStr();
-                if (attribute.find("#") == std::string::npos) {
+                if (value.find("#") == std::string::npos) {
                     // Must be a primitive type
                     // e.g. attr->asStr() == (0.,0.,1.)
 
                     Property property = {.variable = attrName,
-                                         .value = makeString(attr->asStr())};
+                                         .value = makeString(value)};
                     node.addProperty(property);
                 }
             } break;
@@ -218,32 +462,29 @@ void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
 
                 if (aggrCnt == 0) continue;
 
-                std::string attribute = attr->asStr();
-                if (attribute.find("#") == std::string::npos) {
+                if (value.find("#") == std::string::npos) {
                     // Must be a primitive type
                     // e.g. attr->asStr() == (0.,0.,1.)
 
                     Property property = {.variable = attrName,
-                                         .value = makeString(attr->asStr())};
+                                         .value = makeString(value)};
                     node.addProperty(property);
                 }
             } break;
             case sdaiINSTANCE:
             case sdaiSELECT: {
-                std::string attribute = attr->asStr();
-                if (attribute.find("*") != std::string::npos)  // Found
+                if (value.find("*") != std::string::npos)  // Found
                 {
                     node.addProperty({.variable = attrName,
-                                      .value = makeString(attr->asStr())});
+                                      .value = makeString(value)});
                     continue;
-                } else if (attribute.find("#") ==
-                           std::string::npos)  // Not found
+                } else if (value.find("#") == std::string::npos)  // Not found
                 {
                     // Must be a primitive type
                     // e.g. attr->asStr() ==
 
                     node.addProperty({.variable = attrName,
-                                      .value = makeString(attr->asStr())});
+                                      .value = makeString(value)});
                 }
             } break;
             default:
@@ -253,78 +494,57 @@ void PushSTEP::getAttributesForNodes(SDAI_Application_instance_ptr pInst,
 }
 
 bool PushSTEP::createRelations() {
-    Registry registry(SchemaInit);
-    STEPfile stepFile(registry, m_lstInst, "", false);
-    stepFile.ReadExchangeFile(m_path);
-
-    int numInst = m_lstInst.InstanceCount();
-
-    std::string entityName = "";
+    if (!readStepFile()) return false;
 
-    // Id of the according entity (e.g #11= ...)
-    int entityId = 0;
+    extractInstances([this](size_t first, size_t last,
+                            ExtractionBuffer &buffer) {
+        extractRelations(first, last, buffer);
+    });
+    return true;
+}
 
-    for (int i = 0; i < numInst; ++i) {
+void PushSTEP::extractRelations(size_t first, size_t last,
+                                ExtractionBuffer &buffer) {
+    for (size_t i = first; i < last; ++i) {
         // Current instance
         SDAI_Application_instance_ptr pInstance = m_lstInst.GetSTEPentity(i);
-
-        m_entity.name = pInstance->EntityName();
-        m_entity.fileId = std::to_string(pInstance->StepFileId());
+        int fileId = pInstance->StepFileId();
 
         if (pInstance->IsComplex()) {
             STEPcomplex* pInstComplex = (STEPcomplex*)pInstance;
-            std::string entityName = "";
-
-            m_entity.name = TYPE_COMPLEX;
+            const std::vector<EntityRef> &refs = m_complexRefs[fileId];
 
-            int complex_counter = 0;
+            // refs[0]: COMPLEX_TYPE node, refs[n + 1]: n-th sub entity
+            size_t complex_counter = 0;
             while (pInstComplex != nullptr) {
                 SDAI_Application_instance_ptr compInst =
                     (SDAI_Application_instance_ptr)pInstComplex;
-                m_entity.name = compInst->EntityName();
-                m_entity.fileId = std::to_string(pInstance->StepFileId());
 
-                Node from = m_nodeIdMap[m_entity.fileId];
-                Node to = m_nodeIdMap[m_entity.fileId + m_entity.name];
+                const EntityRef &from = refs.empty() ? NO_ENTITY : refs[0];
+                const EntityRef &to = complex_counter + 1 < refs.size()
+                                          ? refs[complex_counter + 1]
+                                          : NO_ENTITY;
 
-                createRelation(
-                    from, to,
-                    "entry{num: " + std::to_string(complex_counter) + "}");
+                buffer.relations.push_back(
+                    {.from = &from,
+                     .to = &to,
+                     .relation = "entry{num: " +
+                                 std::to_string(complex_counter) + "}"});
                 ++complex_counter;
 
-                getAttributesForRelations(compInst);
+                getAttributesForRelations(compInst, to, buffer);
 
                 pInstComplex = pInstComplex->sc;
             }
         } else {
-            getAttributesForRelations(pInstance);
+            getAttributesForRelations(pInstance, m_entityRefs[fileId], buffer);
         }
     }
-    return true;
 }
 
-EntityInfo PushSTEP::getEntityInfoFromId(std::string idStr) {
-    // Deletes null-terminator
-    idStr.erase(std::find(idStr.begin(), idStr.end(), '\0'), idStr.end());
-
-    // Removes "#"
-    idStr = idStr.substr(1, idStr.size());
-
-    if (!isInteger(idStr)) {
-        return {.name = "", .fileId = ""};
-    }
-
-    // Convert the id to an int
-    int idNum = std::stoi(idStr);
-
-    // Searches a certain entity
-    MgrNode* mgrnode = m_lstInst.FindFileId(idNum);
-    auto instance = mgrnode->GetApplication_instance();
-
-    return {.name = instance->EntityName(), .fileId = idStr};
-}
-
-void PushSTEP::getAttributesForRelations(SDAI_Application_instance_ptr pInst) {
+void PushSTEP::getAttributesForRelations(SDAI_Application_instance_ptr pInst,
+                                         const EntityRef &from,
+                                         ExtractionBuffer &buffer) {
     if (pInst == nullptr) {
         Logger::error("failed to read the attributes");
         return;
@@ -362,8 +582,6 @@ void PushSTEP::getAttributesForRelations(SDAI_Application_instance_ptr pInst) {
                 continue;
             else
                 attr = redefAttr;
-        } else {
-            if (attr->IsDerived()) auto test = true;
         }
 
         if (attrName.find(".") != std::string::npos) {
@@ -373,19 +591,17 @@ void PushSTEP::getAttributesForRelations(SDAI_Application_instance_ptr pInst) {
                 throw std::runtime_error("something went wrong ...");
         }
 
+        // asStr() creates a new string on every call
+        std::string value = attr->asStr();
+
         // TYPE: SELECT and INSTANCE
         if (attrType == sdaiSELECT || attrType == sdaiINSTANCE) {
-            auto test = attr->NonRefType();
-            std::string value = attr->asStr();
-
             if (value.find("#") != std::string::npos) {
                 if (value[0] == '#') {
                     // Normal set
-                    Node from = m_nodeIdMap[m_entity.fileId + m_entity.name];
-
-                    EntityInfo entity = getEntityInfoFromId(attr->asStr());
-                    Node to = m_nodeIdMap[entity.fileId + entity.name];
-                    createRelation(from, to, attrName);
+                    buffer.relations.push_back({.from = &from,
+                                                .to = &findEntity(value),
+                                                .relation = attrName});
 
                     continue;
                 } else {
@@ -393,25 +609,28 @@ void PushSTEP::getAttributesForRelations(SDAI_Application_instance_ptr pInst) {
                     // e.g. SET_REPRESENTATION_ITEM((#854,#853))
 
                     auto data = convertTypedSet(value);
-                    Node from = m_nodeIdMap[m_entity.fileId + m_entity.name];
-
                     Node intermediateNode;
                     intermediateNode.createId();
                     intermediateNode.setLabel("SelectInstance");
                     intermediateNode.addProperty(
                         {.variable = "type", .value = data.first});
 
-                    createNode(intermediateNode);
-                    createRelation(from, intermediateNode, attrName);
+                    buffer.nodes.push_back(intermediateNode);
+                    buffer.createdRefs.push_back(
+                        {intermediateNode.getId(), "SelectInstance"});
+                    const EntityRef *intermediate = &buffer.createdRefs.back();
 
-                    int counter = 0;
+                    buffer.relations.push_back({.from = &from,
+                                                .to = intermediate,
+                                                .relation = attrName});
 
-                    for (auto entry : data.second) {
-                        EntityInfo entity = getEntityInfoFromId(entry);
-                        Node to = m_nodeIdMap[entity.fileId + entity.name];
+                    int counter = 0;
 
-                        createRelation(intermediateNode, to,
-                                       "entry_" + std::to_string(counter));
+                    for (auto &entry : data.second) {
+                        buffer.relations.push_back(
+                            {.from = intermediate,
+                             .to = &findEntity(entry),
+                             .relation = "entry_" + std::to_string(counter)});
                         ++counter;
                     }
                 }
@@ -427,23 +646,21 @@ void PushSTEP::getAttributesForRelations(SDAI_Application_instance_ptr pInst) {
             if (aggrCnt == 0) continue;
 
             // Make sure to link nodes and no "primitive data types"
-            if (attr->asStr().find("#") != std::string::npos) {
+            if (value.find("#") != std::string::npos) {
                 int counter = 0;
-                std::vector<std::string> attrList =
-                    getEntriesAggregate(attr->asStr());
-                Node from = m_nodeIdMap[m_entity.fileId + m_entity.name];
-
-                for (auto entry : attrList) {
-                    Node to;
-
-                    if (entry.find("#") != std::string::npos) {
-                        EntityInfo entity = getEntityInfoFromId(entry);
-                        to = m_nodeIdMap[entity.fileId + entity.name];
-                    }
-                    if (!(to.getLabel() == "")) {
-                        createRelation(
-                            from, to,
-                            attrName + "_list_type_" + std::to_string(counter));
+                std::vector<std::string> attrList = getEntriesAggregate(value);
+
+                for (auto &entry : attrList) {
+                    const EntityRef &to = entry.find("#") != std::string::npos
+                                              ? findEntity(entry)
+                                              : NO_ENTITY;
+
+                    if (!to.label.empty()) {
+                        buffer.relations.push_back(
+                            {.from = &from,
+                             .to = &to,
+                             .relation = attrName + "_list_type_" +
+                                         std::to_string(counter)});
                         ++counter;
                     }
                 }
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <string_view>
 
 #include "Graph.h"
+#include "ImportCsv.h"
+#include "ParallelFor.hpp"
 #include "Tools.hpp"
 #include "VersionControl.h"
 
@@ -27,48 +32,160 @@ class STEPAnalyser {
     int m_numEntities;
 };
 
+// node created for a STEP instance (generated Id and label)
+struct EntityRef {
+    std::string id;
+    std::string label;
+};
+
+// limits of the uploads while pushing a file
+// the queued statements are sent (and committed as an independent
+// transaction) as soon as one of the limits is reached, 0 means no limit
+struct CommitPolicy {
+    // rows of a single UNWIND statement (bulk ingest)
+    size_t rowsPerStatement = ROWS_PER_STATEMENT;
+
+    // statements of a single request
+    size_t maxStatements = 100;
+
+    // estimated size of the queued rows and statements
+    size_t maxBytes = 64 * 1024 * 1024;
+};
+
+// nodes and relations extracted from a range of instances
+// buffers are filled in parallel and merged in instance order
+struct ExtractionBuffer {
+    struct PendingRelation {
+        const EntityRef *from;
+        const EntityRef *to;
+        std::string relation;
+    };
+
+    std::vector<Node> nodes;
+
+    // nodes created while extracting the relations (SelectInstance)
+    std::deque<EntityRef> createdRefs;
+
+    std::vector<PendingRelation> relations;
+};
+
 class PushSTEP : public Graph {
    public:
     PushSTEP();
     PushSTEP(std::string path, DatabaseInfo databaseInfo);
+
+    // no database connection, only for exportImportCsv
+    explicit PushSTEP(std::string path);
     ~PushSTEP();
 
     std::pair<std::string, std::vector<std::string>> convertTypedSet(
         std::string select);
 
-    void commitChanges(std::string message);
+    // writes the tracked changes as commit to the history database
+    void commitChanges(std::string message, HistoryOptions options = {});
 
     void createNode(Node node) override;
     void createRelation(Node from, Node to, std::string relation) override;
 
     Blob getTrackedChanges() { return m_trackChanges; }
 
+    // Bulk ingest (default): nodes are grouped by label and relations by
+    // type, every group is written with a single UNWIND statement
+    // Otherwise one statement per node and relation is sent
+    void setBulkIngest(bool bulkIngest) { m_bulkIngest = bulkIngest; }
+
+    // Uploads are split into several transactions (see CommitPolicy), so
+    // the memory used for the pending queries stays bounded
+    void setCommitPolicy(CommitPolicy policy) { m_commitPolicy = policy; }
+
     // Create new graph
     bool build();
 
+    // Writes the nodes and relations of the STEP file as csv files for
+    // neo4j-admin database import (same graph as build) to the directory
+    bool exportImportCsv(const std::string &directory);
+
+    // Parse the STEP file into m_lstInst
+    // the file is only read once, nodes and relations are derived from the
+    // same instances
+    bool readStepFile();
+
     // Create the cypher queries for all nodes
+    // the attributes are extracted in parallel (see setNumWorkers)
     bool createInstanceNodes();
 
     // Create the cypher queries to link the nodes to each other
     bool createRelations();
 
-    // Return StepEntity struct from a given id (e.g. #24)
-    EntityInfo getEntityInfoFromId(std::string idStr);
+    // number of threads extracting the instances (default: hardware threads)
+    void setNumWorkers(size_t numWorkers) { m_numWorkers = numWorkers; }
+
+    // Push the UNWIND statements of the collected node and relation groups
+    void flushBatches();
+
+    // Sends all pending queries as one transaction
+    void commitPending();
+
+    // Returns the node a reference (e.g. #24) is linked to, an empty
+    // EntityRef if there is none
+    const EntityRef &findEntity(std::string_view reference) const;
 
     // Search primitive attributes and create properties for the nodes
     void getAttributesForNodes(SDAI_Application_instance_ptr pInst, Node &node);
 
     // Read the attributes of the current entity which are needed to create
     // relationships between the nodes
-    void getAttributesForRelations(SDAI_Application_instance_ptr pInst);
+    void getAttributesForRelations(SDAI_Application_instance_ptr pInst,
+                                   const EntityRef &from,
+                                   ExtractionBuffer &buffer);
 
    private:
+    // sends the pending queries if a limit of the commit policy is reached
+    void commitIfFull();
+
+    // extracts the instances [first, last) into the buffer
+    void extractNodes(size_t first, size_t last, ExtractionBuffer &buffer);
+    void extractRelations(size_t first, size_t last, ExtractionBuffer &buffer);
+
+    // runs the extraction on a window of chunks of instances in parallel and
+    // merges the buffers in instance order before the next window
+    void extractInstances(
+        const std::function<void(size_t, size_t, ExtractionBuffer &)>
+            &extract);
+
     std::string m_filePath;
     std::string m_fileName;
 
-    // stores the name and the id of the current instance
-    EntityInfo m_entity; 
-    
-    std::map<std::string, Node> m_nodeIdMap;
+    // indexed by STEP file id, filled by createInstanceNodes
+    // the node a reference to the instance is linked to (complex instances:
+    // the sub entity with the name of the instance)
+    std::vector<EntityRef> m_entityRefs;
+    // complex instances: the COMPLEX_TYPE node followed by the sub entities
+    std::vector<std::vector<EntityRef>> m_complexRefs;
     Blob m_trackChanges;
+
+    // True if the STEP file was already parsed
+    bool m_isFileRead;
+
+    bool m_bulkIngest;
+
+    size_t m_numWorkers;
+
+    // set while exporting, receives the nodes and relations instead of the
+    // database
+    std::unique_ptr<ImportCsvWriter> m_csvWriter;
+
+    // Rows of the UNWIND statements, grouped by label/relation
+    std::map<std::string, json> m_nodeBatches;
+    std::map<std::string, json> m_relationBatches;
+
+    CommitPolicy m_commitPolicy;
+
+    // estimated size of the rows and statements not sent yet
+    size_t m_pendingBytes = 0;
+
+    // progress of the upload
+    size_t m_numCommits = 0;
+    size_t m_numNodes = 0;
+    size_t m_numRelations = 0;
 };
\ No newline at end of file
@@ -8,8 +8,7 @@ STEPAnalyser::STEPAnalyser(std::string path)
 STEPAnalyser::~STEPAnalyser() {}
 
 void STEPAnalyser::analyseFile() {
-    Registry registry(SchemaInit);
-    STEPfile stepFile(registry, m_lstInst, "", false);
+    STEPfile stepFile(getSchemaRegistry(), m_lstInst, "", false);
     stepFile.ReadExchangeFile(m_filePath);
     m_numEntities = m_lstInst.InstanceCount();
 }
\ No newline at end of file
@@ -1,16 +1,31 @@
 #include "VersionControl.h"
 
+#include <charconv>
+#include <unordered_set>
+
+#include "BlobCodec.h"
+#include "ByteCodec.hpp"
 #include "Tools.hpp"
 
+// separator of the changes stored as strings by older versions
 const string separator = ";";
+
+// snapshot: version, records (tag, fields), SNAPSHOT_END
+// node: id, labels, properties; relation: from, to, type, properties
+// property values are json text, so they are restored unchanged
+const uint64_t SNAPSHOT_VERSION = 1;
+const uint64_t SNAPSHOT_END = 0;
+const uint64_t SNAPSHOT_NODE = 1;
+const uint64_t SNAPSHOT_RELATION = 2;
+
+// bytes per snapshot part (before base64)
+const size_t SNAPSHOT_PART_SIZE = 4 << 20;
+
+// bytes per blob part of a commit (before base64)
+const size_t BLOB_PART_SIZE = 1 << 20;
 Blob::Blob() {}
 Blob::~Blob() {}
 
-std::string propertyToNeo4j(Property property) {
-    return (property.variable + separator + removeQuotation(property.value) +
-            separator);
-}
-
 Modified modifiedStrToData(std::string dataStr) {
     Modified data;
     std::vector<std::string> list = getListFromStrings(dataStr, separator[0]);
@@ -50,35 +65,72 @@ Relation addedRelationStrToData(std::string dataStr) {
 }
 
 VersionControl::VersionControl()
-    : Graph(), m_latestId(""), m_branch(""){}
+    : Graph(),
+      m_latestId(""),
+      m_branch(""),
+      m_snapshotInterval(HistoryOptions().snapshotInterval),
+      m_compressBlobs(HistoryOptions().compressBlobs) {}
 
-VersionControl::VersionControl(DatabaseInfo databaseInfo)
+VersionControl::VersionControl(DatabaseInfo databaseInfo,
+                               HistoryOptions options)
     : m_workDb(databaseInfo),
       m_latestId(""),
-      m_branch("main"){
+      m_branch("main"),
+      m_snapshotInterval(options.snapshotInterval),
+      m_compressBlobs(options.compressBlobs) {
 
     DatabaseInfo historyDb = databaseInfo;
     historyDb.databaseName = "history";
     this->initRestInterface(historyDb);
+    prepareHistory();
 
     m_work = std::make_unique<PullSTEP>("", databaseInfo);
 }
 
 VersionControl::~VersionControl() {}
 
+void VersionControl::prepareHistory() {
+    if (hasBackend()) return;
+
+    sendQuery("CREATE CONSTRAINT branch_name IF NOT EXISTS FOR (b:" +
+              BRANCH_LABEL + ") REQUIRE b.name IS UNIQUE");
+    sendQuery("CREATE INDEX snapshot_commit IF NOT EXISTS FOR (s:" +
+              SNAPSHOT_LABEL + ") ON (s.commit)");
+
+    if (!getLatestId().empty()) return;
+
+    // history without HEAD, the chain is followed once
+    Node firstCommit;
+    firstCommit.setLabel("first_commit");
+    if (matchNodes(firstCommit).empty()) return;
+
+    std::string latestId = getLatestIdFromChain();
+    sendQuery(m_cypher.setBranchHeadQuery(m_branch, latestId));
+    Logger::log("created HEAD of branch " + m_branch + " at " + latestId);
+}
+
 std::string VersionControl::getLatestId() {
-    Blob blob;
-    std::vector<string> labels = getAllLabels();
+    if (hasBackend()) return getLatestIdFromChain();
+
+    m_latestId = "";
+    ResultDecoder::decode(
+        sendQuery(m_cypher.branchHeadQuery(m_branch)), [this](ResultRow &row) {
+            if (!row.empty() && row[0].type == ResultValue::Type::Scalar)
+                m_latestId = row[0].value;
+        });
+
+    return m_latestId;
+}
 
+std::string VersionControl::getLatestIdFromChain() {
     Node next;
     Node current;
     current.setLabel("first_commit");
     current = getNode(current);
     current.deleteProperties();
-    int counter = 0;
 
     do {
-        next = getNextNode(current, "main");
+        next = getNextNode(current, m_branch);
         if (next.isEmpty()) {
             m_latestId = current.getId();
             break;
@@ -87,8 +139,6 @@ std::string VersionControl::getLatestId() {
         }
         current.setLabel(next.getLabel());
         current.setId(next.getId());
-
-        ++counter;
     } while (!next.isEmpty());
 
     return m_latestId;
@@ -98,151 +148,392 @@ void VersionControl::commitBlob(Blob blob) {
     Node commitNode;
     commitNode.setId(uuid::generateUuidV4());
 
-    std::vector<Modified> modifiedNodes = blob.getModified();
-    std::vector<Node> newNodes = blob.getNewNodes();
-    std::vector<Relation> newRelations = blob.getNewRelations();
-
-    if (getAllLabels().empty()) {
-        Node firstNode("first_commit");
-        firstNode.setLabel("first_commit");
-        std::string query = m_cypher.createNodeQuery(firstNode);
-        sendQuery(query);
-        commitNode.setLabel(blob.getMessage());
-        m_latestId = "first_commit";
-    } else {
-        commitNode.setLabel(blob.getMessage());
-        m_latestId = getLatestId();
+    Node firstNode("first_commit");
+    firstNode.setLabel("first_commit");
+    commitNode.setLabel(blob.getMessage());
+
+    // backends follow the chain, the server uses the HEAD of the branch
+    if (hasBackend()) {
+        if (getAllLabels().empty()) {
+            createNode(firstNode);
+            m_latestId = "first_commit";
+        } else {
+            m_latestId = getLatestId();
+        }
     }
 
     // Push date
     commitNode.addProperty(
         {.variable = "date", .value = makeString(getCurrentTime())});
 
-    int counterModified = 0;
-    int counterNodesAdded = 0;
-    int counterRelationsAdded = 0;
-    for (auto &modified : modifiedNodes) {
-        std::string modifiedStr = modified.nodeId;
-        modifiedStr += separator;
-        modifiedStr += propertyToNeo4j(modified.propertyOld);
-        modifiedStr += propertyToNeo4j(modified.propertyNew);
+    // the changes are stored as binary blob, split into base64 encoded
+    // properties blob_0, blob_1, ... (see BlobCodec)
+    size_t numParts = 0;
+    auto addPart = [&commitNode, &numParts](std::string &chunk) {
         commitNode.addProperty(
-            {.variable = "modified_" + std::to_string(counterModified),
-             .value = makeString(modifiedStr)});
-        ++counterModified;
-    }
+            {.variable = "blob_" + std::to_string(numParts++),
+             .value = makeString(base64Encode(chunk))});
+    };
 
-    for (auto &nodeadded : newNodes) {
-        std::string addedNodeStr = nodeadded.getLabel();
-        addedNodeStr += separator + "Id" + separator + nodeadded.getId();
-        std::vector<Property> properties = nodeadded.getProperties();
-        addedNodeStr += separator;
-        for (auto &property : properties) {
-            property.value = removeQuotation(property.value);
-            addedNodeStr += propertyToNeo4j(property);
-        }
+    BlobEncoder encoder(m_compressBlobs, BLOB_PART_SIZE, addPart);
+    encoder.add(blob);
+    encoder.finish();
 
-        commitNode.addProperty(
-            {.variable = "node_added_" + std::to_string(counterNodesAdded),
-             .value = makeString(addedNodeStr)});
-        ++counterNodesAdded;
-    }
+    commitNode.addProperty({.variable = "blob_encoding",
+                            .value = makeString(encoder.getEncoding())});
+    commitNode.addProperty({.variable = "blob_parts",
+                            .value = makeString(std::to_string(numParts))});
 
-    for (auto &relationAdded : newRelations) {
-        std::string addedRelationStr;
-        addedRelationStr += relationAdded.nodeIdFrom + separator +
-                            relationAdded.nodeIdTo + separator +
-                            relationAdded.relation;
+    if (!hasBackend()) {
+        // commit and HEAD are written in one transaction
+        pushQueryToJson(m_cypher.prepareBranchQuery(firstNode, m_branch));
+        pushQueryToJson(m_cypher.commitQuery(commitNode, m_branch));
 
-        commitNode.addProperty(
-            {.variable =
-                 "relation_added_" + std::to_string(counterRelationsAdded),
-             .value = makeString(addedRelationStr)});
-        ++counterRelationsAdded;
-    }
+        sendQueries();
 
-    // https://community.neo4j.com/t5/neo4j-graph-platform/can-i-add-jsonobject-as-a-value-to-a-property-in-a-node/m-p/34590
-    // You can add a JSON string as a property to a node, but a JSON structure
-    // is not supported
+        m_latestId = commitNode.getId();
+        return;
+    }
 
-    std::string query = m_cypher.createNodeQuery(commitNode);
-    this->sendQuery(query);
+    createNode(commitNode);
 
     if (commitNode.getLabel() != "first_commit") {
         Node from(m_latestId);
 
         Node to(commitNode.getId());
-        sendQuery(m_cypher.createRelation(from, to, m_branch));
+        createRelation(from, to, m_branch);
     }
 }
 
 void VersionControl::checkout(std::string commitId) {
-    bool terminate = false;
-    std::vector<string> labels = getAllLabels();
+    Stopwatch stopwatch;
 
-    if (labels.empty()) {
-        Logger::log("database is empty");
+    std::vector<std::string> commitIds = getCommitPath(commitId);
+    if (commitIds.empty()) {
+        Logger::error("Commit \"" + commitId + "\" does not exist.");
         return;
     }
 
-    Node currentNode;
-    currentNode.setLabel("first_commit");
-    currentNode = getNode(currentNode);
-    currentNode = getNextNode(currentNode, "main");
+    m_work = std::make_unique<PullSTEP>("", this->m_workDb);
+    m_work->deleteDatabase();
 
-    if(currentNode.isEmpty()){
-        Logger::error("History structure is not consistent.");
-        return;
+    // only the commits after the latest snapshot are replayed
+    size_t first = restoreSnapshot(commitIds);
+    for (size_t index = first; index < commitIds.size(); ++index)
+        loadCommit(getNode(Node(commitIds[index])));
+
+    // the working graph is the replayed state of the commit now (the working
+    // graph at commit time may differ), long replays are stored as snapshot
+    size_t replayed = commitIds.size() - first;
+    if (m_snapshotInterval > 0 && replayed >= m_snapshotInterval &&
+        !hasBackend() && !m_work->hasBackend())
+        writeSnapshot(commitIds.back());
+
+    m_work->writeStep(false);
+
+    stopwatch.stop();
+    Logger::log("checked out commit " + commitId + " (replayed " +
+                std::to_string(replayed) + " of " +
+                std::to_string(commitIds.size()) + " commits) in " +
+                std::to_string(stopwatch.getElapsedTime()) + " s");
+}
+
+std::vector<std::string> VersionControl::getCommitPath(std::string label) {
+    std::vector<std::string> commitIds;
+
+    Node firstCommit("first_commit");
+    firstCommit.setLabel("first_commit");
+
+    if (!hasBackend()) {
+        CypherQuery query = m_cypher.commitPathQuery(firstCommit, m_branch);
+        query.parameters["label"] = label;
+
+        ResultDecoder::decode(sendQuery(query), [&commitIds](ResultRow &row) {
+            if (!row.empty() && row[0].type == ResultValue::Type::List)
+                commitIds = std::move(row[0].entries);
+        });
+        return commitIds;
     }
 
-    m_work = std::make_unique<PullSTEP>("", this->m_workDb);
-    m_work->deleteDatabase();
+    Node current = getNextNode(firstCommit, m_branch);
+    while (!current.isEmpty()) {
+        commitIds.push_back(current.getId());
+        if (current.getLabel() == label) return commitIds;
 
-    if (std::find(labels.begin(), labels.end(), commitId) != labels.end()) {
-        while (!terminate) {
-            if ((currentNode.getLabel() == commitId) || currentNode.isEmpty())
-                terminate = true;
+        current = getNextNode(current, m_branch);
+    }
+
+    return {};
+}
 
-            loadCommit(currentNode);
-            currentNode = getNextNode(currentNode, "main");
+void VersionControl::writeSnapshot(std::string commitId) {
+    Stopwatch stopwatch;
+
+    ByteWriter writer;
+    writer.writeVarint(SNAPSHOT_VERSION);
+
+    auto writeProperties = [&writer](const ResultValue &properties) {
+        size_t count = 0;
+        for (auto &property : properties.fields)
+            if (property.variable != "Id") ++count;
+
+        writer.writeVarint(count);
+        for (auto &property : properties.fields) {
+            if (property.variable == "Id") continue;
+            writer.writeString(property.variable);
+            writer.writeString(property.value);
+        }
+    };
+
+    // row: id, labels, properties
+    ResultDecoder::decode(
+        m_work->sendQuery("MATCH (n) RETURN n.Id, labels(n), properties(n)"),
+        [&](ResultRow &row) {
+            if (row.size() < 3 || row[0].type != ResultValue::Type::Scalar)
+                return;
+
+            writer.writeVarint(SNAPSHOT_NODE);
+            writer.writeString(row[0].value);
+
+            std::vector<std::string> &labels = row[1].entries;
+            labels.erase(
+                std::remove(labels.begin(), labels.end(), STEP_ENTITY_LABEL),
+                labels.end());
+            writer.writeVarint(labels.size());
+            for (auto &label : labels) writer.writeString(label);
+
+            writeProperties(row[2]);
+        });
+
+    // row: start id, type, properties, end id
+    ResultDecoder::decode(
+        m_work->sendQuery(
+            "MATCH (a)-[r]->(b) RETURN a.Id, type(r), properties(r), b.Id"),
+        [&](ResultRow &row) {
+            if (row.size() < 4 || row[0].type != ResultValue::Type::Scalar ||
+                row[3].type != ResultValue::Type::Scalar)
+                return;
+
+            writer.writeVarint(SNAPSHOT_RELATION);
+            writer.writeString(row[0].value);
+            writer.writeString(row[3].value);
+            writer.writeString(row[1].value);
+            writeProperties(row[2]);
+        });
+
+    writer.writeVarint(SNAPSHOT_END);
+
+    // properties are limited in size, large snapshots are split into parts
+    std::string data = writer.release();
+    json parts = json::array();
+    for (size_t offset = 0; offset < data.size();
+         offset += SNAPSHOT_PART_SIZE) {
+        parts.push_back(
+            {{"part", parts.size()},
+             {"data", base64Encode(data.substr(offset, SNAPSHOT_PART_SIZE))}});
+    }
+
+    sendQuery(CypherQuery{
+        .statement = m_cypher.createSnapshotQuery(),
+        .parameters = {{"commit", commitId}, {"parts", parts}}});
+
+    stopwatch.stop();
+    Logger::log("wrote snapshot of commit " + commitId + " (" +
+                std::to_string(data.size()) + " bytes) in " +
+                std::to_string(stopwatch.getElapsedTime()) + " s");
+}
+
+size_t VersionControl::restoreSnapshot(
+    const std::vector<std::string> &commitIds) {
+    if (hasBackend() || m_work->hasBackend()) return 0;
+
+    std::unordered_set<std::string> snapshots;
+    ResultDecoder::decode(
+        sendQuery(CypherQuery{.statement = m_cypher.snapshotCommitsQuery(),
+                              .parameters = {{"ids", commitIds}}}),
+        [&snapshots](ResultRow &row) {
+            if (!row.empty() && row[0].type == ResultValue::Type::Scalar)
+                snapshots.insert(row[0].value);
+        });
+
+    size_t next = commitIds.size();
+    while (next > 0 && !snapshots.count(commitIds[next - 1])) --next;
+    if (next == 0) return 0;
+
+    std::string data;
+    ResultDecoder::decode(
+        sendQuery(CypherQuery{.statement = m_cypher.snapshotPartsQuery(),
+                              .parameters = {{"commit", commitIds[next - 1]}}}),
+        [&data](ResultRow &row) {
+            if (row.empty() || row[0].type != ResultValue::Type::Scalar)
+                return;
+
+            std::vector<BYTE> part = base64Decode(row[0].value);
+            data.append(part.begin(), part.end());
+        });
+
+    ByteReader reader(data);
+    if (reader.readVarint() != SNAPSHOT_VERSION)
+        throw_database_error("unsupported snapshot version");
+
+    auto readProperties = [&reader](json &row) {
+        for (uint64_t count = reader.readVarint(); count > 0; --count) {
+            std::string variable = reader.readString();
+            row[variable] = json::parse(reader.readString());
+        }
+    };
+
+    // rows grouped by labels and relation (type with properties)
+    std::map<std::string, json> nodeRows;
+    std::map<std::string, json> relationRows;
+
+    for (uint64_t tag = reader.readVarint(); tag != SNAPSHOT_END;
+         tag = reader.readVarint()) {
+        if (tag == SNAPSHOT_NODE) {
+            json row;
+            row["Id"] = reader.readString();
+
+            std::string labels;
+            for (uint64_t count = reader.readVarint(); count > 0; --count)
+                labels += (labels.empty() ? "" : ":") + reader.readString();
+
+            readProperties(row);
+            nodeRows[labels].push_back(row);
+        } else if (tag == SNAPSHOT_RELATION) {
+            json row;
+            row["from"] = reader.readString();
+            row["to"] = reader.readString();
+            std::string relation = reader.readString();
+
+            // same notation as the push, e.g. entry{num: 0}
+            json properties = json::object();
+            readProperties(properties);
+            if (!properties.empty()) {
+                std::string entries;
+                for (auto &[variable, value] : properties.items())
+                    entries += (entries.empty() ? "" : ", ") + variable +
+                               ": " + value.dump();
+                relation += "{" + entries + "}";
+            }
+
+            relationRows[relation].push_back(row);
+        } else {
+            throw_database_error("invalid snapshot record");
         }
-    } else {
-        Logger::error("Commit \"" + commitId + "\" does not exist.");
-        return;
     }
 
-    Logger::log("checked out commit " + commitId);
+    // Nodes first, the relations point to them
+    for (auto &rows : nodeRows)
+        m_work->pushBatchedQueries(rows.first.empty()
+                                       ? m_cypher.mergeNodesQuery(rows.first)
+                                       : m_cypher.createNodesQuery(rows.first),
+                                   "rows", rows.second);
+    m_work->sendQueries();
+
+    for (auto &rows : relationRows)
+        m_work->pushBatchedQueries(m_cypher.createRelationsQuery(rows.first),
+                                   "rows", rows.second);
+    m_work->sendQueries();
+
+    Logger::log("restored snapshot of commit " + commitIds[next - 1]);
+    return next;
 }
 
 void VersionControl::loadCommit(Node commit) {
     std::vector<Property> properties = commit.getProperties();
 
-    m_work = std::make_unique<PullSTEP>("", m_workDb);
+    if (!m_work) m_work = std::make_unique<PullSTEP>("", m_workDb);
 
-    for (auto &property : properties) {
-        if (property.variable.find("modified_") != std::string::npos) {
-            Modified modified = modifiedStrToData(property.value);
-            Node node;
-            node.setId(modified.nodeId);
-            node.addProperty(modified.propertyOld);
+    // the changes of a commit are sent in one transaction, added nodes and
+    // relations with UNWIND statements
+    bool batched = !m_work->hasBackend();
+    std::map<std::string, json> nodeRows;
+    std::map<std::string, json> relationRows;
+
+    auto applyModified = [&](Modified &modified) {
+        Node node;
+        node.setId(modified.nodeId);
+        node.addProperty(modified.propertyOld);
 
+        if (batched)
+            m_work->pushQueryToJson(m_cypher.modifyNodeQueryParameterized(
+                node, modified.propertyNew));
+        else
             m_work->modifyNode(node, modified.propertyNew);
-        } else if (property.variable.find("node_added_") != std::string::npos) {
-            Node node = addedNodeStrToData(property.value);
-            m_work->createNode(node);
-        } else if (property.variable.find("relation_added_") !=
-                   std::string::npos) {
-            Relation relation = addedRelationStrToData(property.value);
-            Node from;
-            from.setId(relation.nodeIdFrom);
-            from = m_work->getNode(from);
-
-            Node to;
-            to.setId(relation.nodeIdTo);
-            to = m_work->getNode(to);
-            m_work->createRelation(from, to, relation.relation);
+    };
+
+    auto applyNode = [&](Node &node) {
+        if (!batched) return m_work->createNode(node);
+
+        json row;
+        row["Id"] = node.getId();
+        for (auto &nodeProperty : node.getProperties())
+            row[nodeProperty.variable] =
+                cypherStringToValue(nodeProperty.value);
+        nodeRows[node.getLabel()].push_back(row);
+    };
+
+    auto applyRelation = [&](Relation &relation) {
+        if (!batched)
+            return m_work->createRelation(Node(relation.nodeIdFrom),
+                                          Node(relation.nodeIdTo),
+                                          relation.relation);
+
+        relationRows[relation.relation].push_back(
+            {{"from", relation.nodeIdFrom}, {"to", relation.nodeIdTo}});
+    };
+
+    // binary blob: encoding and parts blob_0, blob_1, ...
+    std::string encoding;
+    std::map<size_t, std::string> parts;
+    for (auto &property : properties) {
+        if (property.variable == "blob_encoding") encoding = property.value;
+
+        if (property.variable.rfind("blob_", 0) != 0) continue;
+        std::string_view number = property.variable;
+        number.remove_prefix(5);
+
+        size_t index;
+        const char *last = number.data() + number.size();
+        auto [end, error] = std::from_chars(number.data(), last, index);
+        if (error == std::errc() && end == last) parts[index] = property.value;
+    }
+
+    if (!encoding.empty()) {
+        BlobDecoder decoder(encoding, applyModified, applyNode, applyRelation);
+        for (auto &part : parts) {
+            std::vector<BYTE> chunk = base64Decode(part.second);
+            decoder.write(std::string_view(
+                reinterpret_cast<const char *>(chunk.data()), chunk.size()));
+        }
+        decoder.finish();
+    } else {
+        // commits of older versions, the changes are ';' separated strings
+        for (auto &property : properties) {
+            if (property.variable.find("modified_") != std::string::npos) {
+                Modified modified = modifiedStrToData(property.value);
+                applyModified(modified);
+            } else if (property.variable.find("node_added_") !=
+                       std::string::npos) {
+                Node node = addedNodeStrToData(property.value);
+                applyNode(node);
+            } else if (property.variable.find("relation_added_") !=
+                       std::string::npos) {
+                Relation relation = addedRelationStrToData(property.value);
+                applyRelation(relation);
+            }
         }
     }
 
-    m_work->writeStep(false);
+    if (!batched) return;
+
+    for (auto &rows : nodeRows)
+        m_work->pushBatchedQueries(m_cypher.createNodesQuery(rows.first),
+                                   "rows", rows.second);
+
+    for (auto &rows : relationRows)
+        m_work->pushBatchedQueries(m_cypher.createRelationsQuery(rows.first),
+                                   "rows", rows.second);
+
+    m_work->sendQueries();
 }
@@ -17,12 +17,6 @@ struct Modified {
     Property propertyNew;
 };
 
-struct Relation {
-    std::string nodeIdFrom;
-    std::string nodeIdTo;
-    std::string relation;
-};
-
 class Blob {
    public:
     Blob();
@@ -63,28 +57,71 @@ class Blob {
     std::string m_message;
 };
 
+// settings of the history, passed to VersionControl (e.g. through
+// PushSTEP::commitChanges or ManipulateGraph::commitChanges)
+struct HistoryOptions {
+    // replayed commits that create a snapshot (see checkout), 0: no snapshots
+    size_t snapshotInterval = 50;
+
+    // zlib compression of the changes of a commit
+    bool compressBlobs = true;
+};
+
 class VersionControl : public Graph {
    public:
     VersionControl();
 
-    VersionControl(DatabaseInfo databaseInfo);
+    VersionControl(DatabaseInfo databaseInfo, HistoryOptions options = {});
     ~VersionControl();
 
     // Writes blob object to history database and creates a unique identifier
     void commitBlob(Blob blob);
 
+    // applies the changes of the commit to the working graph
     void loadCommit(Node commit);
 
     // Returns stepfile of a specific version
+    // restores the latest snapshot before the commit and replays the commits
+    // after it, if at least snapshot interval commits were replayed the
+    // result is stored as snapshot of the commit
     void checkout(std::string commitId);
 
+    // replayed commits that create a snapshot, 0: no snapshots
+    void setSnapshotInterval(size_t interval) { m_snapshotInterval = interval; }
+
+    // zlib compression of the changes of a commit (default: on)
+    void setBlobCompression(bool compress) { m_compressBlobs = compress; }
+
+    // id of the commit HEAD of the current branch points to (single indexed
+    // lookup)
     std::string getLatestId();
 
    protected:
+    // creates the indexes of the history (branch names, snapshots) and the
+    // HEAD of histories written before branches had one
+    void prepareHistory();
+
+    // follows the commits of the branch from the first commit
+    std::string getLatestIdFromChain();
+
+    // ids of the commits from the first commit (excluded) to the commit with
+    // the label, empty if there is no such commit
+    std::vector<std::string> getCommitPath(std::string label);
+
+    // stores the working graph as binary snapshot of the commit, the working
+    // graph has to be the replayed state of the commit (see checkout)
+    void writeSnapshot(std::string commitId);
+
+    // loads the latest snapshot of the commits into the working graph,
+    // returns the index of the first commit that still has to be replayed
+    size_t restoreSnapshot(const std::vector<std::string> &commitIds);
+
     std::unique_ptr<PullSTEP> m_work;  // Graph where we currently work on
 
     DatabaseInfo
         m_workDb;  // Info about the database where we currently work on
     std::string m_latestId;
     std::string m_branch;    // Current branch
+    size_t m_snapshotInterval;
+    bool m_compressBlobs;
 };
\ No newline at end of file
@@ -1,20 +1,124 @@
 #include "AdjacencyMatrix.h"
 
+#include <charconv>
+
 AdjacencyMatrix::AdjacencyMatrix() {}
 
 AdjacencyMatrix::~AdjacencyMatrix() {}
 
-void AdjacencyMatrix::replaceNode(Node node, Node newNode) {
-    for (auto &entry : m_nodes) {
-        if (entry.compare(node)) entry = newNode;
+void AdjacencyMatrix::setNodes(std::vector<Node> nodes) {
+    m_nodes = nodes;
+    buildNodeIndex();
+    m_parentIndexValid = false;
+}
+
+void AdjacencyMatrix::addNode(Node node) {
+    m_nodeIndex.emplace(node.getId(), m_nodes.size());
+    m_nodes.push_back(node);
+    m_parentIndexValid = false;
+}
+
+Matrix AdjacencyMatrix::getRelationMatrix() {
+    Matrix relations;
+
+    for (size_t row = 0; row + 1 < m_rowOffsets.size(); ++row) {
+        std::vector<std::string> relationRow(m_nodes.size(), "");
+        for (auto &edge : getEdges(row)) {
+            std::string &entry = relationRow[edge.target];
+            if (entry.empty())
+                entry = m_relationNames[edge.relationId];
+            else
+                entry += ";" + m_relationNames[edge.relationId];
+        }
+        relations.push_back(relationRow);
+    }
+    return relations;
+}
+
+void AdjacencyMatrix::insertNode(Node node) {
+    m_nodes.insert(m_nodes.begin(), node);
+
+    // existing nodes move one position, the new node is the first
+    // occurrence of its id
+    for (auto &entry : m_nodeIndex) ++entry.second;
+    m_nodeIndex[node.getId()] = 0;
+
+    // existing relations point one node further
+    for (auto &edge : m_edges) ++edge.target;
+
+    // the new node has no relations yet
+    if (m_rowOffsets.size() > 1) m_rowOffsets.insert(m_rowOffsets.begin(), 0);
+
+    m_parentIndexValid = false;
+    m_attributeIndexValid = false;
+}
+
+void AdjacencyMatrix::addRelationRow(std::vector<std::string> row) {
+    for (size_t column = 0; column < row.size(); ++column) {
+        if (row[column].empty()) continue;
+
+        // multiple relations are separated by semicolons
+        for (auto &relation : getListFromStrings(row[column]))
+            m_edges.push_back({column, internRelation(relation)});
     }
+    m_rowOffsets.push_back(m_edges.size());
+    m_parentIndexValid = false;
+    m_attributeIndexValid = false;
+}
+
+void AdjacencyMatrix::setRelations(
+    const std::vector<IndexedRelation> &relations) {
+    size_t rows = m_nodes.size();
+
+    // counting sort by source node
+    m_rowOffsets.assign(rows + 1, 0);
+    for (auto &relation : relations) {
+        if (relation.from < rows && relation.to < rows)
+            ++m_rowOffsets[relation.from + 1];
+    }
+    for (size_t row = 0; row < rows; ++row)
+        m_rowOffsets[row + 1] += m_rowOffsets[row];
+
+    m_edges.resize(m_rowOffsets[rows]);
+    std::vector<size_t> position(m_rowOffsets.begin(), m_rowOffsets.end() - 1);
+    for (auto &relation : relations) {
+        if (relation.from < rows && relation.to < rows)
+            m_edges[position[relation.from]++] = {
+                relation.to, internRelation(relation.relation)};
+    }
+
+    // keep the column order of the dense matrix
+    for (size_t row = 0; row < rows; ++row) {
+        std::stable_sort(
+            m_edges.begin() + m_rowOffsets[row],
+            m_edges.begin() + m_rowOffsets[row + 1],
+            [](const Edge &a, const Edge &b) { return a.target < b.target; });
+    }
+    m_parentIndexValid = false;
+    m_attributeIndexValid = false;
+}
+
+std::span<const AdjacencyMatrix::Edge> AdjacencyMatrix::getEdges(
+    size_t index) const {
+    if (index + 1 >= m_rowOffsets.size()) return {};
+
+    return std::span<const Edge>(m_edges.data() + m_rowOffsets[index],
+                                 m_rowOffsets[index + 1] - m_rowOffsets[index]);
+}
+
+void AdjacencyMatrix::replaceNode(Node node, Node newNode) {
+    size_t index = findIndex(node);
+    if (index == m_nodes.size()) return;
+
+    m_nodes[index] = newNode;
+    if (newNode.getId() != node.getId()) buildNodeIndex();
 }
 
 std::string AdjacencyMatrix::toString() {
     std::string matrixStr = "";
     Matrix matrix;
     auto nodes_copy = m_nodes;
-    auto relations_copy = m_relations;
+    auto relations_copy = getRelationMatrix();
     std::vector<std::string> row;
     row.push_back("");  // first element is empty
     for (auto &node : nodes_copy) {
@@ -23,11 +127,13 @@ std::string AdjacencyMatrix::toString() {
     matrix.push_back(row);
     row.clear();
 
-    int row_counter = 0;
+    size_t row_counter = 0;
     for (auto &node : nodes_copy) {
         row.push_back(node.toString());
-        for (auto &relationStr : relations_copy[row_counter])
-            row.push_back(relationStr);
+        if (row_counter < relations_copy.size()) {
+            for (auto &relationStr : relations_copy[row_counter])
+                row.push_back(relationStr);
+        }
         matrix.push_back(row);
         row.clear();
         ++row_counter;
@@ -38,35 +144,32 @@ std::string AdjacencyMatrix::toString() {
 
 void AdjacencyMatrix::clear() {
     m_nodes.clear();
-    m_relations.clear();
+    m_nodeIndex.clear();
+    m_rowOffsets = {0};
+    m_edges.clear();
+    m_relationNames.clear();
+    m_relationIds.clear();
+    m_relationAttributes.clear();
+    m_relationListIndices.clear();
+    m_attributeIds.clear();
+    m_parentOffsets.clear();
+    m_parents.clear();
+    m_parentIndexValid = false;
+    m_attributeEdges.clear();
+    m_attributeIndexValid = false;
 }
 
 Node AdjacencyMatrix::getNextNode(Node from, std::string relation) {
     Node to;
-    int currentNode = 0;
-    for (auto &node : m_nodes) {
-        if (node.compare(from)) {
-            int currentRelation = 0;
-            for (auto &relationStr : m_relations[currentNode]) {
-                if (relationStr.find(";") != std::string::npos) {
-                    // multiple relations found!
-                    std::vector<std::string> relations =
-                        getListFromStrings(relationStr);
-                    auto it =
-                        std::find(relations.begin(), relations.end(), relation);
-
-                    if (it != relations.end()) {
-                        to = m_nodes[currentRelation];
-                        break;
-                    }
-                } else if (relationStr == relation) {
-                    to = m_nodes[currentRelation];
-                    break;
-                }
-                ++currentRelation;
-            }
+
+    auto relationId = m_relationIds.find(relation);
+    if (relationId == m_relationIds.end()) return to;
+
+    for (auto &edge : getEdges(findIndex(from))) {
+        if (edge.relationId == relationId->second) {
+            to = m_nodes[edge.target];
+            break;
         }
-        ++currentNode;
     }
 
     if (to.getNodeType() == NodeType::COMPLEX) return findComplexParent(to);
@@ -74,6 +177,41 @@ Node AdjacencyMatrix::getNextNode(Node from, std::string relation) {
     return to;
 }
 
+std::vector<Node> AdjacencyMatrix::findAttributeTargets(
+    Node from, const std::string &attribute) {
+    std::vector<Node> targets;
+
+    auto attributeId = m_attributeIds.find(attribute);
+    if (attributeId == m_attributeIds.end()) return targets;
+
+    size_t index = findIndex(from);
+    if (index + 1 >= m_rowOffsets.size()) return targets;
+
+    if (!m_attributeIndexValid) buildAttributeIndex();
+
+    auto begin = m_attributeEdges.begin() + m_rowOffsets[index];
+    auto end = m_attributeEdges.begin() + m_rowOffsets[index + 1];
+    auto first = std::lower_bound(begin, end, attributeId->second,
+                                  [this](size_t edge, size_t attribute) {
+                                      return m_relationAttributes
+                                                 [m_edges[edge].relationId] <
+                                             attribute;
+                                  });
+
+    for (auto it = first; it != end; ++it) {
+        const Edge &edge = m_edges[*it];
+        if (m_relationAttributes[edge.relationId] != attributeId->second)
+            break;
+
+        Node to = m_nodes[edge.target];
+        if (to.getNodeType() == NodeType::COMPLEX)
+            targets.push_back(findComplexParent(to));
+        else
+            targets.push_back(to);
+    }
+    return targets;
+}
+
 Node AdjacencyMatrix::findComplexParent(Node complexChildNode) {
     Node complexNode;
 
@@ -87,79 +225,47 @@ Node AdjacencyMatrix::findComplexParent(Node complexChildNode) {
 }
 
 std::vector<Node> AdjacencyMatrix::findParents(Node childNode) {
-    int currentNode = 0;
     std::vector<Node> parents;
-    for (auto &node : m_nodes) {
-        if (node.compare(childNode)) {
-            int currentRow = 0;
-            for (auto &row : m_relations) {
-                if (!row[currentNode].empty()) {
-                    // parent found!
-                    parents.push_back(m_nodes[currentRow]);
-                }
-
-                ++currentRow;
-            }
-            return parents;
-        }
-        ++currentNode;
-    }
+
+    size_t index = findIndex(childNode);
+    if (index == m_nodes.size()) return parents;
+
+    if (!m_parentIndexValid) buildParentIndex();
+
+    for (size_t i = m_parentOffsets[index]; i < m_parentOffsets[index + 1];
+         ++i)
+        parents.push_back(m_nodes[m_parents[i]]);
+
     return parents;
 }
 
 std::vector<Property> AdjacencyMatrix::findProperties(Node searchNode) {
     std::vector<Property> properties;
 
-    for (auto &node : m_nodes) {
-        if (node.compare(searchNode)) return node.getProperties();
-    }
+    size_t index = findIndex(searchNode);
+    if (index < m_nodes.size()) return m_nodes[index].getProperties();
+
     return properties;
 }
 
 std::vector<std::string> AdjacencyMatrix::getNodeRelations(Node nodeRelation) {
     std::vector<std::string> relations;
-    int currentNode = 0;
 
-    for (auto &node : m_nodes) {
-        if (node.compare(nodeRelation)) {
-            for (auto &relation : m_relations[currentNode]) {
-                if (relation.find(";") != std::string::npos) {
-                    // multiple relations found!
-                    std::vector<std::string> multipleRelations =
-                        getListFromStrings(relation);
-                    relations.insert(relations.end(), multipleRelations.begin(),
-                                     multipleRelations.end());
-                } else if (!relation.empty())
-                    relations.push_back(relation);
-            }
-
-            return relations;
-        }
-        ++currentNode;
-    }
+    for (auto &edge : getEdges(findIndex(nodeRelation)))
+        relations.push_back(m_relationNames[edge.relationId]);
+
     return relations;
 }
 
 std::vector<Node> AdjacencyMatrix::findChildren(Node parentNode) {
     std::vector<Node> children;
-    int currentNode = 0;
 
-    for (auto &node : m_nodes) {
-        if (node.compare(parentNode)) {
-            std::vector<std::string> relations = m_relations[currentNode];
-            int currentRelation = 0;
-            for (auto &relation : relations) {
-                // if relation is not empty --> node must be linked with another
-                // one
-                if (!relation.empty()) {
-                    // if(!m_matrix.nodes[currentRelation].compare(parentNode))
-                    children.push_back(m_nodes[currentRelation]);
-                }
-
-                ++currentRelation;
-            }
-        }
-        ++currentNode;
+    auto edges = getEdges(findIndex(parentNode));
+    for (size_t i = 0; i < edges.size(); ++i) {
+        // multiple relations to the same node yield one child
+        if (i > 0 && edges[i].target == edges[i - 1].target) continue;
+
+        children.push_back(m_nodes[edges[i].target]);
     }
     return children;
 }
@@ -174,21 +280,120 @@ std::vector<Node> AdjacencyMatrix::findNodes(std::string label) {
 }
 
 void AdjacencyMatrix::markComplexNodes() {
-    std::vector<Node> complexNodes;
+    std::vector<size_t> complexNodes;
 
     // collect complex types
-    for (auto &node : m_nodes) {
-        if (node.getNodeType() == NodeType::COMPLEX) {
-            std::vector<Node> children = findChildren(node);
-            complexNodes.insert(complexNodes.end(), children.begin(),
-                                children.end());
+    for (size_t index = 0; index < m_nodes.size(); ++index) {
+        if (m_nodes[index].getNodeType() == NodeType::COMPLEX) {
+            for (auto &edge : getEdges(index))
+                complexNodes.push_back(edge.target);
         }
     }
 
     // mark complex nodes
-    for (auto &node : m_nodes) {
-        for (auto &complexNode : complexNodes) {
-            if (node.compare(complexNode)) node.setNodeType(NodeType::COMPLEX);
+    for (auto &index : complexNodes)
+        m_nodes[index].setNodeType(NodeType::COMPLEX);
+}
+
+void AdjacencyMatrix::finalize() {
+    if (!m_parentIndexValid) buildParentIndex();
+    if (!m_attributeIndexValid) buildAttributeIndex();
+}
+
+size_t AdjacencyMatrix::findIndex(const Node &searchNode) const {
+    auto it = m_nodeIndex.find(searchNode.getId());
+    if (it == m_nodeIndex.end()) return m_nodes.size();
+
+    return it->second;
+}
+
+void AdjacencyMatrix::buildNodeIndex() {
+    m_nodeIndex.clear();
+    m_nodeIndex.reserve(m_nodes.size());
+    for (size_t index = 0; index < m_nodes.size(); ++index)
+        m_nodeIndex.emplace(m_nodes[index].getId(), index);
+}
+
+size_t AdjacencyMatrix::internRelation(const std::string &relation) {
+    auto it = m_relationIds.find(relation);
+    if (it != m_relationIds.end()) return it->second;
+
+    m_relationNames.push_back(relation);
+    m_relationIds[relation] = m_relationNames.size() - 1;
+
+    // "<attribute>_list_type_<n>" is the n-th entry of an aggregate
+    std::string attribute = relation;
+    int listIndex = -1;
+
+    const std::string listType = "_list_type_";
+    size_t pos = relation.find(listType);
+    if (pos != std::string::npos) {
+        attribute = relation.substr(0, pos);
+
+        const char *begin = relation.data() + pos + listType.size();
+        const char *end = relation.data() + relation.size();
+        if (std::from_chars(begin, end, listIndex).ec != std::errc())
+            listIndex = 0;
+    }
+
+    auto attributeId =
+        m_attributeIds.emplace(attribute, m_attributeIds.size()).first;
+    m_relationAttributes.push_back(attributeId->second);
+    m_relationListIndices.push_back(listIndex);
+
+    return m_relationNames.size() - 1;
+}
+
+void AdjacencyMatrix::buildParentIndex() {
+    size_t nodes = m_nodes.size();
+    size_t rows = std::min(nodes, m_rowOffsets.size() - 1);
+
+    // counting sort by target node, each parent is listed once
+    m_parentOffsets.assign(nodes + 1, 0);
+    for (size_t row = 0; row < rows; ++row) {
+        auto edges = getEdges(row);
+        for (size_t i = 0; i < edges.size(); ++i) {
+            if (i > 0 && edges[i].target == edges[i - 1].target) continue;
+            if (edges[i].target < nodes) ++m_parentOffsets[edges[i].target + 1];
+        }
+    }
+    for (size_t node = 0; node < nodes; ++node)
+        m_parentOffsets[node + 1] += m_parentOffsets[node];
+
+    m_parents.resize(m_parentOffsets[nodes]);
+    std::vector<size_t> position(m_parentOffsets.begin(),
+                                 m_parentOffsets.end() - 1);
+    for (size_t row = 0; row < rows; ++row) {
+        auto edges = getEdges(row);
+        for (size_t i = 0; i < edges.size(); ++i) {
+            if (i > 0 && edges[i].target == edges[i - 1].target) continue;
+            if (edges[i].target < nodes)
+                m_parents[position[edges[i].target]++] = row;
         }
     }
+    m_parentIndexValid = true;
+}
+
+void AdjacencyMatrix::buildAttributeIndex() {
+    m_attributeEdges.resize(m_edges.size());
+    for (size_t edge = 0; edge < m_edges.size(); ++edge)
+        m_attributeEdges[edge] = edge;
+
+    auto compare = [this](size_t a, size_t b) {
+        size_t relationA = m_edges[a].relationId;
+        size_t relationB = m_edges[b].relationId;
+        if (m_relationAttributes[relationA] != m_relationAttributes[relationB])
+            return m_relationAttributes[relationA] <
+                   m_relationAttributes[relationB];
+
+        return m_relationListIndices[relationA] <
+               m_relationListIndices[relationB];
+    };
+
+    for (size_t row = 0; row + 1 < m_rowOffsets.size(); ++row)
+        std::stable_sort(m_attributeEdges.begin() + m_rowOffsets[row],
+                         m_attributeEdges.begin() + m_rowOffsets[row + 1],
+                         compare);
+
+    m_attributeIndexValid = true;
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <span>
+#include <unordered_map>
+
 #include "Tools.hpp"
 #include "TypesNeo4j.h"
 
@@ -18,26 +21,55 @@
      * |  Node2  |     Relation1    |    no Relation      |
      * |_________|__________________|_____________________|
      *
+     * Internally the matrix is stored sparse (compressed rows): only
+     * existing relations are kept as (target index, relation id) pairs,
+     * relation strings are interned. A reverse index for the parents of
+     * a node is built on demand, nodes are found by their id through a
+     * hash index.
 **/
 
 class AdjacencyMatrix {
    public:
+    // relation from a row node to the node at index "target"
+    struct Edge {
+        size_t target;
+        size_t relationId;
+    };
+
+    // relation between two nodes given by their index in the matrix
+    struct IndexedRelation {
+        size_t from;
+        size_t to;
+        std::string relation;
+    };
+
     AdjacencyMatrix();
     ~AdjacencyMatrix();
 
-    void setNodes(std::vector<Node> nodes) { m_nodes = nodes; }
+    void setNodes(std::vector<Node> nodes);
     void setAdjacencyMatrix(AdjacencyMatrix matrix) {
-        m_nodes = matrix.getNodes();
-        m_relations = matrix.getRelationMatrix();
+        *this = std::move(matrix);
     }
 
     std::vector<Node> getNodes() { return m_nodes; }
-    Matrix getRelationMatrix() { return m_relations; }
 
-    void addNode(Node node) { m_nodes.push_back(node); }
-    void insertNode(Node node) { m_nodes.insert(m_nodes.begin(), node); }
-    void addRelationRow(std::vector<std::string> row) {
-        m_relations.push_back(row);
+    // materializes the dense relation matrix (multiple relations between
+    // the same nodes are separated by semicolons)
+    Matrix getRelationMatrix();
+
+    void addNode(Node node);
+    void insertNode(Node node);
+
+    // appends the relations of the next node, given as a dense row
+    void addRelationRow(std::vector<std::string> row);
+
+    // replaces all relations by the given list
+    void setRelations(const std::vector<IndexedRelation> &relations);
+
+    // relations that start at the node with the given index
+    std::span<const Edge> getEdges(size_t index) const;
+    const std::string &getRelationName(size_t relationId) const {
+        return m_relationNames[relationId];
     }
 
     void replaceNode(Node node, Node newNode);
@@ -47,6 +79,11 @@ class AdjacencyMatrix {
     // returns the nodes that follow a specified relation from a given node
     Node getNextNode(Node from, std::string relation);
 
+    // returns the nodes linked to a given node through a STEP attribute,
+    // aggregate entries ("<attribute>_list_type_<n>") are ordered by n
+    std::vector<Node> findAttributeTargets(Node from,
+                                           const std::string &attribute);
+
     // returns the parent of an entity which is part of a complex instance
     Node findComplexParent(Node childNode);
 
@@ -67,7 +104,46 @@ class AdjacencyMatrix {
     // searches complex nodes and sets their type to NodeType::Complex
     void markComplexNodes();
 
+    // builds the indices that are otherwise built on demand, afterwards the
+    // lookups (find*, getNextNode ...) only read the matrix and may be used
+    // by several threads until the matrix is modified again
+    void finalize();
+
    private:
+    // index of the node in m_nodes, m_nodes.size() if not found
+    size_t findIndex(const Node &node) const;
+    void buildNodeIndex();
+
+    size_t internRelation(const std::string &relation);
+    void buildParentIndex();
+    void buildAttributeIndex();
+
     std::vector<Node> m_nodes;
-    Matrix m_relations;
-};
\ No newline at end of file
+
+    // node id -> position in m_nodes (first occurrence)
+    std::unordered_map<std::string, size_t> m_nodeIndex;
+
+    // compressed rows: relations of row i are
+    // m_edges[m_rowOffsets[i] .. m_rowOffsets[i + 1]), sorted by target
+    std::vector<size_t> m_rowOffsets = {0};
+    std::vector<Edge> m_edges;
+
+    // interned relation strings
+    std::vector<std::string> m_relationNames;
+    std::unordered_map<std::string, size_t> m_relationIds;
+
+    // relation id -> STEP attribute id and list position (-1 if the
+    // relation is no aggregate entry), parsed once when interned
+    std::vector<size_t> m_relationAttributes;
+    std::vector<int> m_relationListIndices;
+    std::unordered_map<std::string, size_t> m_attributeIds;
+
+    // per row: positions in m_edges ordered by (attribute, list position)
+    std::vector<size_t> m_attributeEdges;
+    bool m_attributeIndexValid = false;
+
+    // reverse index (parents), same layout as the rows
+    std::vector<size_t> m_parentOffsets;
+    std::vector<size_t> m_parents;
+    bool m_parentIndexValid = false;
+};
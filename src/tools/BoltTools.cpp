@@ -0,0 +1,824 @@
+#include "BoltTools.h"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "DatabaseError.hpp"
+#include "Logger.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// request messages
+const uint8_t BOLT_HELLO = 0x01;
+const uint8_t BOLT_RESET = 0x0F;
+const uint8_t BOLT_RUN = 0x10;
+const uint8_t BOLT_BEGIN = 0x11;
+const uint8_t BOLT_COMMIT = 0x12;
+const uint8_t BOLT_PULL = 0x3F;
+
+// response messages
+const uint8_t BOLT_SUCCESS = 0x70;
+const uint8_t BOLT_RECORD = 0x71;
+const uint8_t BOLT_IGNORED = 0x7E;
+const uint8_t BOLT_FAILURE = 0x7F;
+
+// graph structures contained in records
+const uint8_t BOLT_NODE = 0x4E;
+const uint8_t BOLT_RELATIONSHIP = 0x52;
+
+// handshake: magic preamble followed by four proposed versions
+// (00 range minor major): 5.0, 4.4-4.2, 4.1, 4.0
+const uint8_t BOLT_HANDSHAKE[20] = {0x60, 0x60, 0xB0, 0x17, 0, 0, 0, 5,
+                                    0,    2,    4,    4,    0, 0, 1, 4,
+                                    0,    0,    0,    4};
+
+const size_t MAX_CHUNK_SIZE = 0xFFFF;
+const size_t READ_BUFFER_SIZE = 1 << 16;
+
+const std::string USER_AGENT = "GraphSTEP/1.0";
+
+// serializes json values as PackStream (big endian)
+class PackStreamWriter {
+   public:
+    void packStructHeader(size_t fields, uint8_t tag) {
+        m_data += static_cast<char>(0xB0 | fields);
+        m_data += static_cast<char>(tag);
+    }
+
+    void pack(const json &value) {
+        switch (value.type()) {
+            case json::value_t::null:
+            case json::value_t::discarded:
+                m_data += static_cast<char>(0xC0);
+                break;
+            case json::value_t::boolean:
+                m_data += static_cast<char>(value.get<bool>() ? 0xC3 : 0xC2);
+                break;
+            case json::value_t::number_integer:
+                packInt(value.get<int64_t>());
+                break;
+            case json::value_t::number_unsigned:
+                if (value.get<uint64_t>() >
+                    uint64_t(std::numeric_limits<int64_t>::max()))
+                    packFloat(value.get<double>());
+                else
+                    packInt(value.get<int64_t>());
+                break;
+            case json::value_t::number_float:
+                packFloat(value.get<double>());
+                break;
+            case json::value_t::string:
+                packString(value.get_ref<const std::string &>());
+                break;
+            case json::value_t::array:
+                packHeader(value.size(), 0x90, 0xD4);
+                for (auto &entry : value) pack(entry);
+                break;
+            case json::value_t::object:
+                packHeader(value.size(), 0xA0, 0xD8);
+                for (auto &[key, entry] : value.items()) {
+                    packString(key);
+                    pack(entry);
+                }
+                break;
+            case json::value_t::binary: {
+                auto &bytes = value.get_binary();
+                if (bytes.size() <= 0xFF) {
+                    m_data += static_cast<char>(0xCC);
+                    writeBigEndian(bytes.size(), 1);
+                } else if (bytes.size() <= 0xFFFF) {
+                    m_data += static_cast<char>(0xCD);
+                    writeBigEndian(bytes.size(), 2);
+                } else {
+                    m_data += static_cast<char>(0xCE);
+                    writeBigEndian(bytes.size(), 4);
+                }
+                m_data.append(bytes.begin(), bytes.end());
+                break;
+            }
+        }
+    }
+
+    const std::string &data() const { return m_data; }
+
+   private:
+    void writeBigEndian(uint64_t value, size_t bytes) {
+        for (size_t i = bytes; i-- > 0;)
+            m_data += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+
+    // tiny header (size < 16) or 8/16/32 bit size
+    void packHeader(size_t size, uint8_t tinyMarker, uint8_t marker) {
+        if (size < 0x10) {
+            m_data += static_cast<char>(tinyMarker | size);
+        } else if (size <= 0xFF) {
+            m_data += static_cast<char>(marker);
+            writeBigEndian(size, 1);
+        } else if (size <= 0xFFFF) {
+            m_data += static_cast<char>(marker + 1);
+            writeBigEndian(size, 2);
+        } else {
+            m_data += static_cast<char>(marker + 2);
+            writeBigEndian(size, 4);
+        }
+    }
+
+    void packInt(int64_t value) {
+        if (value >= -16 && value < 128) {
+            m_data += static_cast<char>(value);
+        } else if (value >= INT8_MIN && value <= INT8_MAX) {
+            m_data += static_cast<char>(0xC8);
+            writeBigEndian(value, 1);
+        } else if (value >= INT16_MIN && value <= INT16_MAX) {
+            m_data += static_cast<char>(0xC9);
+            writeBigEndian(value, 2);
+        } else if (value >= INT32_MIN && value <= INT32_MAX) {
+            m_data += static_cast<char>(0xCA);
+            writeBigEndian(value, 4);
+        } else {
+            m_data += static_cast<char>(0xCB);
+            writeBigEndian(value, 8);
+        }
+    }
+
+    void packFloat(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        m_data += static_cast<char>(0xC1);
+        writeBigEndian(bits, 8);
+    }
+
+    void packString(const std::string &value) {
+        packHeader(value.size(), 0x80, 0xD0);
+        m_data += value;
+    }
+
+    std::string m_data;
+};
+
+// deserializes a PackStream message, nodes and relationships are returned as
+// their property maps (like the "row" format of the http endpoint)
+class PackStreamReader {
+   public:
+    explicit PackStreamReader(const std::string &data) : m_data(data) {}
+
+    // returns the signature of the message, "fields" its number of fields
+    uint8_t unpackStructHeader(size_t &fields) {
+        uint8_t marker = readByte();
+        if ((marker & 0xF0) != 0xB0)
+            throw_database_error("bolt: message is no structure");
+
+        fields = marker & 0x0F;
+        return readByte();
+    }
+
+    // metadata of SUCCESS and FAILURE
+    json unpack() {
+        uint64_t value = 0;
+        switch (readHeader(value)) {
+            case Kind::Null:
+                return json(nullptr);
+            case Kind::Boolean:
+                return json(value != 0);
+            case Kind::Integer:
+                return json(int64_t(value));
+            case Kind::Float:
+                return json(toDouble(value));
+            case Kind::Bytes: {
+                // bytes are returned as a list of numbers
+                json bytes = json::array();
+                for (uint64_t i = 0; i < value; ++i)
+                    bytes.push_back(readByte());
+                return bytes;
+            }
+            case Kind::String:
+                return json(readString(value));
+            case Kind::List: {
+                json list = json::array();
+                for (uint64_t i = 0; i < value; ++i) list.push_back(unpack());
+                return list;
+            }
+            case Kind::Map: {
+                json map = json::object();
+                for (uint64_t i = 0; i < value; ++i) {
+                    std::string key = readKey();
+                    map[key] = unpack();
+                }
+                return map;
+            }
+            case Kind::Struct: {
+                uint8_t tag = readByte();
+                size_t properties = propertiesField(tag, value);
+
+                json fields = json::array();
+                for (uint64_t i = 0; i < value; ++i) fields.push_back(unpack());
+
+                if (properties != std::string::npos) return fields[properties];
+                return fields;
+            }
+        }
+        return json(nullptr);
+    }
+
+    // values of a RECORD, in the format of the ResultDecoder
+    void unpackRow(ResultRow &row) {
+        uint64_t size = 0;
+        if (readHeader(size) != Kind::List)
+            throw_database_error("bolt: record is no list");
+
+        row.resize(size);
+        for (auto &column : row) unpackColumn(column);
+    }
+
+   private:
+    enum class Kind { Null, Boolean, Integer, Float, Bytes, String, List, Map,
+                      Struct };
+
+    // reads the marker and the size (strings, bytes and containers) or the
+    // value (booleans, integers, bits of floats) that follows it
+    Kind readHeader(uint64_t &value) {
+        uint8_t marker = readByte();
+
+        // tiny types
+        if (marker < 0x80 || marker >= 0xF0) {
+            value = uint64_t(int64_t(int8_t(marker)));
+            return Kind::Integer;
+        }
+
+        value = marker & 0x0F;
+        switch (marker & 0xF0) {
+            case 0x80:
+                return Kind::String;
+            case 0x90:
+                return Kind::List;
+            case 0xA0:
+                return Kind::Map;
+            case 0xB0:
+                return Kind::Struct;
+            default:
+                break;
+        }
+
+        switch (marker) {
+            case 0xC0:
+                return Kind::Null;
+            case 0xC1:
+                value = readBigEndian(8);
+                return Kind::Float;
+            case 0xC2:
+            case 0xC3:
+                value = marker - 0xC2;
+                return Kind::Boolean;
+            case 0xC8:
+                value = uint64_t(int64_t(int8_t(readBigEndian(1))));
+                return Kind::Integer;
+            case 0xC9:
+                value = uint64_t(int64_t(int16_t(readBigEndian(2))));
+                return Kind::Integer;
+            case 0xCA:
+                value = uint64_t(int64_t(int32_t(readBigEndian(4))));
+                return Kind::Integer;
+            case 0xCB:
+                value = readBigEndian(8);
+                return Kind::Integer;
+            case 0xCC:
+            case 0xCD:
+            case 0xCE:
+                value = readBigEndian(size_t(1) << (marker - 0xCC));
+                return Kind::Bytes;
+            case 0xD0:
+            case 0xD1:
+            case 0xD2:
+                value = readBigEndian(size_t(1) << (marker - 0xD0));
+                return Kind::String;
+            case 0xD4:
+            case 0xD5:
+            case 0xD6:
+                value = readBigEndian(size_t(1) << (marker - 0xD4));
+                return Kind::List;
+            case 0xD8:
+            case 0xD9:
+            case 0xDA:
+                value = readBigEndian(size_t(1) << (marker - 0xD8));
+                return Kind::Map;
+            default:
+                break;
+        }
+        throw_database_error("bolt: unknown PackStream marker " +
+                             std::to_string(marker));
+    }
+
+    // field of nodes and relationships that holds the properties
+    static size_t propertiesField(uint8_t tag, uint64_t size) {
+        // Node: id, labels, properties (, element id)
+        if (tag == BOLT_NODE && size >= 3) return 2;
+        // Relationship: id, start, end, type, properties (, element ids)
+        if (tag == BOLT_RELATIONSHIP && size >= 5) return 4;
+
+        return std::string::npos;
+    }
+
+    // column of a row: nodes and relationships as maps of their properties,
+    // other structures as lists of their fields
+    void unpackColumn(ResultValue &column) {
+        uint64_t value = 0;
+        Kind kind = readHeader(value);
+
+        switch (kind) {
+            case Kind::Null:
+                column.type = ResultValue::Type::Null;
+                return;
+            case Kind::Bytes:
+                column.type = ResultValue::Type::List;
+                for (uint64_t i = 0; i < value; ++i)
+                    column.entries.push_back(std::to_string(readByte()));
+                return;
+            case Kind::List:
+                column.type = ResultValue::Type::List;
+                column.entries.resize(value);
+                for (auto &entry : column.entries) unpackText(entry, true);
+                return;
+            case Kind::Map:
+                column.type = ResultValue::Type::Map;
+                column.fields.resize(value);
+                for (auto &field : column.fields) {
+                    field.variable = readKey();
+                    unpackText(field.value, false);
+                }
+                // sorted by key like a json object
+                sortProperties(column.fields);
+                return;
+            case Kind::Struct: {
+                uint8_t tag = readByte();
+                size_t properties = propertiesField(tag, value);
+
+                if (properties == std::string::npos) {
+                    column.type = ResultValue::Type::List;
+                    column.entries.resize(value);
+                    for (auto &entry : column.entries) unpackText(entry, true);
+                    return;
+                }
+
+                std::string skipped;
+                for (uint64_t i = 0; i < value; ++i) {
+                    if (i == properties)
+                        unpackColumn(column);
+                    else
+                        unpackText(skipped, false);
+                }
+                return;
+            }
+            default:
+                column.type = ResultValue::Type::Scalar;
+                appendText(kind, value, column.value, true);
+                return;
+        }
+    }
+
+    // appends the next value as json text, "plain": strings without quotes
+    void unpackText(std::string &out, bool plain) {
+        uint64_t value = 0;
+        Kind kind = readHeader(value);
+        appendText(kind, value, out, plain);
+    }
+
+    void appendText(Kind kind, uint64_t value, std::string &out, bool plain) {
+        switch (kind) {
+            case Kind::Null:
+                out += "null";
+                break;
+            case Kind::Boolean:
+                out += value ? "true" : "false";
+                break;
+            case Kind::Integer:
+                out += std::to_string(int64_t(value));
+                break;
+            case Kind::Float:
+                // same format as json::dump()
+                out += json(toDouble(value)).dump();
+                break;
+            case Kind::Bytes:
+                out += '[';
+                for (uint64_t i = 0; i < value; ++i) {
+                    if (i > 0) out += ',';
+                    out += std::to_string(readByte());
+                }
+                out += ']';
+                break;
+            case Kind::String:
+                if (plain)
+                    out += readString(value);
+                else
+                    out += json(readString(value)).dump();
+                break;
+            case Kind::List:
+                out += '[';
+                for (uint64_t i = 0; i < value; ++i) {
+                    if (i > 0) out += ',';
+                    unpackText(out, false);
+                }
+                out += ']';
+                break;
+            case Kind::Map:
+                out += '{';
+                for (uint64_t i = 0; i < value; ++i) {
+                    if (i > 0) out += ',';
+                    out += json(readKey()).dump() + ":";
+                    unpackText(out, false);
+                }
+                out += '}';
+                break;
+            case Kind::Struct: {
+                uint8_t tag = readByte();
+                size_t properties = propertiesField(tag, value);
+
+                std::string skipped;
+                if (properties == std::string::npos) out += '[';
+                for (uint64_t i = 0; i < value; ++i) {
+                    if (properties == std::string::npos) {
+                        if (i > 0) out += ',';
+                        unpackText(out, false);
+                    } else if (i == properties) {
+                        unpackText(out, false);
+                    } else {
+                        unpackText(skipped, false);
+                    }
+                }
+                if (properties == std::string::npos) out += ']';
+                break;
+            }
+        }
+    }
+
+    std::string readKey() {
+        uint64_t size = 0;
+        if (readHeader(size) != Kind::String)
+            throw_database_error("bolt: map key is no string");
+        return readString(size);
+    }
+
+    static double toDouble(uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint8_t readByte() {
+        if (m_position >= m_data.size())
+            throw_database_error("bolt: unexpected end of message");
+        return static_cast<uint8_t>(m_data[m_position++]);
+    }
+
+    uint64_t readBigEndian(size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) value = (value << 8) | readByte();
+        return value;
+    }
+
+    std::string readString(uint64_t size) {
+        if (size > m_data.size() - m_position)
+            throw_database_error("bolt: unexpected end of message");
+
+        std::string value = m_data.substr(m_position, size);
+        m_position += size;
+        return value;
+    }
+
+    const std::string &m_data;
+    size_t m_position = 0;
+};
+
+// appends a message split into chunks (2 byte size + data), terminated by an
+// empty chunk
+void appendChunked(std::string &out, const std::string &message) {
+    for (size_t offset = 0; offset < message.size();
+         offset += MAX_CHUNK_SIZE) {
+        size_t size = std::min(MAX_CHUNK_SIZE, message.size() - offset);
+        out += static_cast<char>(size >> 8);
+        out += static_cast<char>(size & 0xFF);
+        out.append(message, offset, size);
+    }
+    out += '\0';
+    out += '\0';
+}
+
+void appendMessage(std::string &out, uint8_t signature,
+                   const std::vector<json> &fields) {
+    PackStreamWriter writer;
+    writer.packStructHeader(fields.size(), signature);
+    for (auto &field : fields) writer.pack(field);
+
+    appendChunked(out, writer.data());
+}
+
+}  // namespace
+
+/**
+ * @brief BoltConnection
+ * socket connection to the server, handles handshake, authentication and
+ * the chunked message framing
+**/
+
+class BoltConnection {
+   public:
+    BoltConnection(const std::string &host, const std::string &port) {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo *addresses = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0)
+            throw_database_error("bolt: unknown host " + host);
+
+        for (addrinfo *address = addresses; address;
+             address = address->ai_next) {
+            m_socket = socket(address->ai_family, address->ai_socktype,
+                              address->ai_protocol);
+            if (m_socket < 0) continue;
+
+            if (connect(m_socket, address->ai_addr, address->ai_addrlen) == 0)
+                break;
+
+            close(m_socket);
+            m_socket = -1;
+        }
+        freeaddrinfo(addresses);
+
+        if (m_socket < 0)
+            throw_database_error("bolt: unable to connect to " + host + ":" +
+                                 port);
+    }
+
+    ~BoltConnection() {
+        if (m_socket >= 0) close(m_socket);
+    }
+
+    // agrees on a protocol version and authenticates (HELLO)
+    void open(const std::string &username, const std::string &password) {
+        send(std::string(reinterpret_cast<const char *>(BOLT_HANDSHAKE),
+                         sizeof(BOLT_HANDSHAKE)));
+
+        char version[4];
+        receive(version, sizeof(version));
+        if (version[2] == 0 && version[3] == 0)
+            throw_database_error("bolt: server supports no proposed version");
+
+        json hello = {{"user_agent", USER_AGENT}, {"scheme", "none"}};
+        if (!username.empty()) {
+            hello["scheme"] = "basic";
+            hello["principal"] = username;
+            hello["credentials"] = password;
+        }
+
+        std::string request;
+        appendMessage(request, BOLT_HELLO, {hello});
+        send(request);
+
+        json metadata;
+        if (readResponse(metadata) != BOLT_SUCCESS)
+            throw_database_error("bolt: authentication failed: " +
+                                 metadata.value("message", std::string()));
+    }
+
+    void send(const std::string &data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t sent = ::send(m_socket, data.data() + offset,
+                                  data.size() - offset, MSG_NOSIGNAL);
+            if (sent <= 0) throw_database_error("bolt: connection lost");
+            offset += sent;
+        }
+    }
+
+    // reads the next response message, "metadata" is the map of
+    // SUCCESS/FAILURE, the values of a RECORD are decoded into "row"
+    uint8_t readResponse(json &metadata, ResultRow &row) {
+        readMessage(m_message);
+
+        PackStreamReader reader(m_message);
+        size_t size = 0;
+        uint8_t signature = reader.unpackStructHeader(size);
+
+        metadata = json::object();
+        if (signature == BOLT_RECORD) {
+            row.clear();
+            if (size > 0) reader.unpackRow(row);
+        } else if (size > 0) {
+            metadata = reader.unpack();
+        }
+        return signature;
+    }
+
+    uint8_t readResponse(json &metadata) {
+        ResultRow row;
+        return readResponse(metadata, row);
+    }
+
+   private:
+    void readMessage(std::string &message) {
+        message.clear();
+        while (true) {
+            uint8_t header[2];
+            receive(reinterpret_cast<char *>(header), sizeof(header));
+
+            size_t size = (size_t(header[0]) << 8) | header[1];
+            if (size == 0) {
+                // empty chunks without data are keep-alive messages
+                if (message.empty()) continue;
+                return;
+            }
+
+            size_t offset = message.size();
+            message.resize(offset + size);
+            receive(message.data() + offset, size);
+        }
+    }
+
+    void receive(char *data, size_t size) {
+        while (size > 0) {
+            if (m_readPosition == m_readBuffer.size()) {
+                m_readBuffer.resize(READ_BUFFER_SIZE);
+                ssize_t received =
+                    recv(m_socket, m_readBuffer.data(), m_readBuffer.size(), 0);
+                if (received <= 0) {
+                    m_readBuffer.clear();
+                    m_readPosition = 0;
+                    throw_database_error("bolt: connection lost");
+                }
+                m_readBuffer.resize(received);
+                m_readPosition = 0;
+            }
+
+            size_t count = std::min(size, m_readBuffer.size() - m_readPosition);
+            std::memcpy(data, m_readBuffer.data() + m_readPosition, count);
+            m_readPosition += count;
+            data += count;
+            size -= count;
+        }
+    }
+
+    int m_socket = -1;
+
+    // last message read (reused for every message)
+    std::string m_message;
+
+    std::vector<char> m_readBuffer;
+    size_t m_readPosition = 0;
+};
+
+BoltInterface::BoltInterface(std::string host, std::string username,
+                             std::string password, std::string database)
+    : m_port(BOLT_DEFAULT_PORT),
+      m_username(username),
+      m_password(password),
+      m_database(database) {
+    // bolt://host:port/
+    if (host.rfind(BOLT_HOST, 0) == 0) host = host.substr(BOLT_HOST.size());
+    host = host.substr(0, host.find('/'));
+
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(']', colon) == std::string::npos) {
+        m_port = host.substr(colon + 1);
+        host = host.substr(0, colon);
+    }
+    // [::1] -> ::1
+    if (host.size() > 1 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+
+    m_host = host;
+}
+
+BoltInterface::~BoltInterface() {}
+
+std::unique_ptr<BoltConnection> BoltInterface::acquireConnection(
+    size_t &generation) {
+    {
+        std::lock_guard<std::mutex> lock(m_connectionMutex);
+        generation = m_connectionGeneration;
+
+        if (!m_idleConnections.empty()) {
+            std::unique_ptr<BoltConnection> connection =
+                std::move(m_idleConnections.back());
+            m_idleConnections.pop_back();
+            return connection;
+        }
+    }
+
+    // connected without the lock, other requests are not blocked
+    auto connection = std::make_unique<BoltConnection>(m_host, m_port);
+    connection->open(m_username, m_password);
+    return connection;
+}
+
+void BoltInterface::releaseConnection(
+    std::unique_ptr<BoltConnection> connection, size_t generation) {
+    std::lock_guard<std::mutex> lock(m_connectionMutex);
+    if (generation == m_connectionGeneration)
+        m_idleConnections.push_back(std::move(connection));
+}
+
+void BoltInterface::resetConnections() {
+    std::lock_guard<std::mutex> lock(m_connectionMutex);
+    ++m_connectionGeneration;
+    m_idleConnections.clear();
+}
+
+HttpState BoltInterface::postRequest(const std::vector<CypherQuery> &queries,
+                                     QueryResponse &response) {
+    response = QueryResponse();
+
+    // the whole transaction is sent at once, responses are read afterwards
+    std::string request;
+    json begin = json::object();
+    if (!m_database.empty()) begin["db"] = m_database;
+    appendMessage(request, BOLT_BEGIN, {begin});
+
+    const json noParameters = json::object();
+    for (auto &query : queries) {
+        // the parameters (e.g. rows of an UNWIND) are packed without a copy
+        PackStreamWriter run;
+        run.packStructHeader(3, BOLT_RUN);
+        run.pack(query.statement);
+        run.pack(query.parameters.is_null() ? noParameters : query.parameters);
+        run.pack(noParameters);
+        appendChunked(request, run.data());
+
+        appendMessage(request, BOLT_PULL, {json{{"n", -1}}});
+    }
+    appendMessage(request, BOLT_COMMIT, {});
+
+    size_t generation;
+    std::unique_ptr<BoltConnection> connection;
+
+    try {
+        connection = acquireConnection(generation);
+        connection->send(request);
+
+        json metadata;
+        bool failed = false;
+
+        // after a failure the server ignores all messages until RESET
+        auto check = [&](uint8_t signature) {
+            if (signature == BOLT_FAILURE) {
+                response.errors.push_back(
+                    {.code = metadata.value("code", ""),
+                     .message = metadata.value("message", "")});
+                failed = true;
+            }
+            return signature == BOLT_SUCCESS;
+        };
+
+        check(connection->readResponse(metadata));  // BEGIN
+
+        ResultRow row;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            check(connection->readResponse(metadata));  // RUN
+
+            // PULL: records are streamed until SUCCESS
+            uint8_t signature;
+            while ((signature = connection->readResponse(metadata, row)) ==
+                   BOLT_RECORD)
+                response.rows.push_back(std::move(row));
+            check(signature);
+        }
+
+        check(connection->readResponse(metadata));  // COMMIT
+
+        if (failed) {
+            std::string reset;
+            appendMessage(reset, BOLT_RESET, {});
+            connection->send(reset);
+
+            uint8_t signature;
+            while ((signature = connection->readResponse(metadata)) ==
+                   BOLT_IGNORED) {
+            }
+            // a connection that was not reset is not reused
+            if (signature != BOLT_SUCCESS) connection.reset();
+
+            response.rows.clear();
+        }
+    } catch (const std::exception &e) {
+        Logger::error(e.what());
+        resetConnections();
+
+        response.rows.clear();
+        response.errors.push_back(
+            {.code = "Neo.TransientError.General.ConnectionError",
+             .message = e.what()});
+        return HttpState::HTTP_SERVICE_UNAVAILABLE;
+    }
+
+    if (connection) releaseConnection(std::move(connection), generation);
+
+    return HttpState::HTTP_OK;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "RestTools.h"
+
+// prefix of DatabaseInfo::hostName that selects the bolt transport,
+// e.g. bolt://localhost:7687/
+const std::string BOLT_HOST = "bolt://";
+const std::string BOLT_DEFAULT_PORT = "7687";
+
+/**
+ * @brief BoltTools
+ * used for sending queries to the neo4j database via the bolt protocol
+ * (binary PackStream messages instead of json over http)
+ * every request is sent as one pipeline: BEGIN, RUN/PULL per statement,
+ * COMMIT. Records are decoded into result rows while they are received
+ * (see QueryResponse)
+**/
+
+class BoltConnection;
+
+class BoltInterface : public Transport {
+   public:
+    BoltInterface(std::string host, std::string username, std::string password,
+                  std::string database);
+
+    ~BoltInterface();
+
+    HttpState postRequest(const std::vector<CypherQuery>& queries,
+                          QueryResponse& response) override;
+
+    std::string getHost() { return m_host; }
+
+   private:
+    // takes an idle connection (or connects a new one) for a single request
+    // a connection is kept open and reused by later requests
+    std::unique_ptr<BoltConnection> acquireConnection(size_t& generation);
+
+    // returns the connection to the idle ones, unless the connections were
+    // reset while it was in use
+    void releaseConnection(std::unique_ptr<BoltConnection> connection,
+                           size_t generation);
+
+    // drops the idle connections, e.g. after an io error (the server may
+    // have been restarted), connections in use are dropped when their
+    // request is finished
+    void resetConnections();
+
+    std::string m_host;      // e.g. localhost
+    std::string m_port;      // e.g. 7687
+    std::string m_username;  // e.g. neo4j
+    std::string m_password;
+    std::string m_database;  // e.g. neo4j
+
+    // open connections not in use by a request, at most one per concurrent
+    // request
+    std::mutex m_connectionMutex;
+    std::vector<std::unique_ptr<BoltConnection>> m_idleConnections;
+    size_t m_connectionGeneration = 0;  // incremented by resetConnections
+};
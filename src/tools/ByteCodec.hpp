@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "DatabaseError.hpp"
+
+/**
+ * @brief ByteCodec
+ * compact binary encoding (e.g. snapshots of the version control)
+ * unsigned integers are written as varints (7 bits per byte, low bits
+ * first), strings are prefixed with their length
+**/
+
+class ByteWriter {
+   public:
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            m_data += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        m_data += static_cast<char>(value);
+    }
+
+    void writeString(std::string_view value) {
+        writeVarint(value.size());
+        m_data.append(value.data(), value.size());
+    }
+
+    size_t size() const { return m_data.size(); }
+    const std::string &data() const { return m_data; }
+
+    // returns the written bytes and leaves the writer empty
+    std::string release() { return std::exchange(m_data, {}); }
+
+   private:
+    std::string m_data;
+};
+
+// reads the values in the order they were written, throws a DatabaseError
+// on truncated or invalid data
+class ByteReader {
+   public:
+    explicit ByteReader(std::string_view data) : m_data(data) {}
+
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_position >= m_data.size())
+                throw_database_error("truncated binary data");
+
+            uint8_t byte = static_cast<uint8_t>(m_data[m_position++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw_database_error("invalid varint in binary data");
+    }
+
+    std::string readString() {
+        uint64_t length = readVarint();
+        if (length > m_data.size() - m_position)
+            throw_database_error("truncated binary data");
+
+        std::string value(m_data.substr(m_position, length));
+        m_position += length;
+        return value;
+    }
+
+    bool atEnd() const { return m_position >= m_data.size(); }
+
+   private:
+    std::string_view m_data;
+    size_t m_position = 0;
+};
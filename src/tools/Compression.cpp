@@ -0,0 +1,86 @@
+#include "Compression.h"
+
+#include <zlib.h>
+
+#include "DatabaseError.hpp"
+
+namespace {
+// output is produced in pieces of this size
+constexpr size_t OUTPUT_SIZE = 64 << 10;
+}  // namespace
+
+Deflater::Deflater(int level) : m_stream(std::make_unique<z_stream_s>()) {
+    if (deflateInit(m_stream.get(), level) != Z_OK)
+        throw_database_error("failed to initialize zlib compression");
+}
+
+Deflater::~Deflater() { deflateEnd(m_stream.get()); }
+
+void Deflater::write(std::string_view data, std::string &out) {
+    m_stream->next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    m_stream->avail_in = static_cast<uInt>(data.size());
+    deflate(Z_NO_FLUSH, out);
+}
+
+void Deflater::finish(std::string &out) {
+    m_stream->next_in = nullptr;
+    m_stream->avail_in = 0;
+    deflate(Z_FINISH, out);
+}
+
+void Deflater::deflate(int flush, std::string &out) {
+    // until the input is consumed (Z_NO_FLUSH) or the stream ends (Z_FINISH)
+    int result;
+    do {
+        size_t size = out.size();
+        out.resize(size + OUTPUT_SIZE);
+
+        m_stream->next_out = reinterpret_cast<Bytef *>(out.data() + size);
+        m_stream->avail_out = OUTPUT_SIZE;
+        result = ::deflate(m_stream.get(), flush);
+
+        out.resize(out.size() - m_stream->avail_out);
+
+        if (result == Z_STREAM_ERROR)
+            throw_database_error("zlib compression failed");
+    } while (m_stream->avail_out == 0 ||
+             (flush == Z_FINISH && result != Z_STREAM_END));
+}
+
+Inflater::Inflater() : m_stream(std::make_unique<z_stream_s>()) {
+    if (inflateInit(m_stream.get()) != Z_OK)
+        throw_database_error("failed to initialize zlib decompression");
+}
+
+Inflater::~Inflater() { inflateEnd(m_stream.get()); }
+
+void Inflater::write(std::string_view data, std::string &out) {
+    if (data.empty()) return;
+    if (m_finished) throw_database_error("data after the end of zlib stream");
+
+    m_stream->next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    m_stream->avail_in = static_cast<uInt>(data.size());
+
+    // a full output may leave more output in zlib
+    do {
+        size_t size = out.size();
+        out.resize(size + OUTPUT_SIZE);
+
+        m_stream->next_out = reinterpret_cast<Bytef *>(out.data() + size);
+        m_stream->avail_out = OUTPUT_SIZE;
+        int result = ::inflate(m_stream.get(), Z_NO_FLUSH);
+
+        out.resize(out.size() - m_stream->avail_out);
+
+        if (result == Z_STREAM_END) {
+            m_finished = true;
+            if (m_stream->avail_in > 0)
+                throw_database_error("data after the end of zlib stream");
+            return;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR)
+            throw_database_error("invalid zlib data");
+    } while (m_stream->avail_in > 0 || m_stream->avail_out == 0);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Compression
+ * streaming zlib compression, the data may be passed in pieces of any size
+ * and the output is appended piece by piece as well
+**/
+
+struct z_stream_s;
+
+class Deflater {
+   public:
+    // level 0 (none) to 9 (best), -1: zlib default
+    explicit Deflater(int level = -1);
+    ~Deflater();
+
+    // compresses data and appends the output that is ready to out
+    void write(std::string_view data, std::string &out);
+
+    // appends the remaining output, no writes afterwards
+    void finish(std::string &out);
+
+   private:
+    void deflate(int flush, std::string &out);
+
+    std::unique_ptr<z_stream_s> m_stream;
+};
+
+class Inflater {
+   public:
+    Inflater();
+    ~Inflater();
+
+    // decompresses data and appends the output to out
+    void write(std::string_view data, std::string &out);
+
+    // true once the end of the compressed stream was read
+    bool finished() const { return m_finished; }
+
+   private:
+    std::unique_ptr<z_stream_s> m_stream;
+    bool m_finished = false;
+};
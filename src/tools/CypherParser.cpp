@@ -17,16 +17,14 @@ std::string CypherParser::createRelation(Node from, Node to,
     from.setVariable("a");
     to.setVariable("b");
 
-    if (!from.getLabel().empty())
-        cypherStr +=
-            "MATCH (" + from.getVariable() + ":" + from.getLabel() + "),";
-    else
-        cypherStr += "MATCH (" + from.getVariable() + "),";
+    std::string fromLabels = ":" + STEP_ENTITY_LABEL;
+    if (!from.getLabel().empty()) fromLabels = ":" + from.getLabel() + fromLabels;
 
-    if (!to.getLabel().empty())
-        cypherStr += "(" + to.getVariable() + ":" + to.getLabel() + ")\n";
-    else
-        cypherStr += "(" + to.getVariable() + ")\n";
+    std::string toLabels = ":" + STEP_ENTITY_LABEL;
+    if (!to.getLabel().empty()) toLabels = ":" + to.getLabel() + toLabels;
+
+    cypherStr += "MATCH (" + from.getVariable() + fromLabels + "),";
+    cypherStr += "(" + to.getVariable() + toLabels + ")\n";
 
     cypherStr +=
         "WHERE " + from.getVariable() + ".Id = " + makeString(from.getId());
@@ -71,6 +69,44 @@ std::string CypherParser::createNodeQuery(Node node) {
     return query;
 }
 
+std::string CypherParser::createNodesQuery(std::string label) {
+    return "UNWIND $rows AS r CREATE (n:" + label + ":" + STEP_ENTITY_LABEL +
+           ") SET n = r";
+}
+
+std::string CypherParser::createRelationsQuery(std::string relation) {
+    std::string query = "UNWIND $rows AS r\n";
+    query += "MATCH (a:" + STEP_ENTITY_LABEL + "{Id:r.from}),(b:" +
+             STEP_ENTITY_LABEL + "{Id:r.to})\n";
+    query += "CREATE (a)-[:" + relation + "]->(b)";
+    return query;
+}
+
+std::string CypherParser::mergeNodesQuery(std::string label) {
+    std::string query = "UNWIND $rows AS r MERGE (n:" + STEP_ENTITY_LABEL +
+                        "{Id:r.Id}) SET ";
+    if (!label.empty()) query += "n:" + label + ", ";
+    return query + "n = r";
+}
+
+std::string CypherParser::mergeRelationsQuery(std::string relation) {
+    std::string query = "UNWIND $rows AS r\n";
+    query += "MATCH (a:" + STEP_ENTITY_LABEL + "{Id:r.from}),(b:" +
+             STEP_ENTITY_LABEL + "{Id:r.to})\n";
+    query += "MERGE (a)-[:" + relation + "]->(b)";
+    return query;
+}
+
+std::string CypherParser::deleteNodesQuery() {
+    return "UNWIND $ids AS id MATCH (n:" + STEP_ENTITY_LABEL +
+           "{Id:id}) DETACH DELETE n";
+}
+
+std::string CypherParser::setPropertyQuery(std::string variable) {
+    return "UNWIND $ids AS id MATCH (n:" + STEP_ENTITY_LABEL +
+           "{Id:id}) SET n." + variable + " = $value";
+}
+
 std::string CypherParser::matchQuery(Node from, std::string relation, Node to,
                                      std::string ret) {
     from.makeStringProperties();
@@ -137,4 +173,202 @@ std::string CypherParser::modifyNodeQuery(Node node, Property newProperty) {
              newProperty.value + "\n";
 
     return query;
-}
\ No newline at end of file
+}
+
+// ------------------ Parameterized queries ------------------ //
+
+CypherQuery CypherParser::createRelationParameterized(Node from, Node to,
+                                                      std::string relation) {
+    CypherQuery query;
+
+    from.setVariable("a");
+    to.setVariable("b");
+
+    query.statement = "MATCH (" + from.toCypher(query.parameters, "a") +
+                      "),(" + to.toCypher(query.parameters, "b") + ")\n";
+    query.statement += "CREATE (a)-[:" + relation + "]->(b)";
+
+    return query;
+}
+
+CypherQuery CypherParser::createNodeQueryParameterized(Node node) {
+    CypherQuery query;
+    query.statement = "CREATE (" + node.toCypher(query.parameters, "n") + ")";
+    return query;
+}
+
+CypherQuery CypherParser::matchQueryParameterized(Node from,
+                                                  std::string relation,
+                                                  Node to, std::string ret) {
+    CypherQuery query;
+    query.statement = "MATCH (" + from.toCypher(query.parameters, "from") +
+                      ")-[" + relation + "]->(" +
+                      to.toCypher(query.parameters, "to") + ")";
+
+    if (!ret.empty()) query.statement += " RETURN " + ret;
+
+    return query;
+}
+
+CypherQuery CypherParser::matchQueryParameterized(Node node, std::string ret) {
+    CypherQuery query;
+    query.statement = "MATCH (" + node.toCypher(query.parameters, "n") + ")";
+
+    if (!ret.empty()) query.statement += " RETURN " + ret;
+
+    return query;
+}
+
+CypherQuery CypherParser::deleteQueryParameterized(Node node) {
+    CypherQuery query = matchQueryParameterized(node);
+    query.statement += " DETACH DELETE " + node.getVariable();
+    return query;
+}
+
+CypherQuery CypherParser::conditionQueryParameterized(Node node,
+                                                      Property condition,
+                                                      std::string ret) {
+    CypherQuery query = matchQueryParameterized(node);
+    query.parameters["condition"] = cypherStringToValue(condition.value);
+    query.statement += " WHERE " + node.getVariable() + "." +
+                       condition.variable + "=$condition RETURN " + ret;
+    return query;
+}
+
+CypherQuery CypherParser::modifyNodeQueryParameterized(Node node,
+                                                       Node modified) {
+    node.setVariable("a");
+    CypherQuery query = matchQueryParameterized(node);
+
+    int counter = 0;
+    for (auto &property : modified.getProperties()) {
+        std::string parameter = "set_" + std::to_string(counter);
+        query.parameters[parameter] = cypherStringToValue(property.value);
+        query.statement +=
+            "\nSET a." + property.variable + "=$" + parameter;
+        ++counter;
+    }
+
+    return query;
+}
+
+CypherQuery CypherParser::modifyNodeQueryParameterized(Node node,
+                                                       Property newProperty) {
+    node.setVariable("a");
+    CypherQuery query = matchQueryParameterized(node);
+
+    // the matched properties are replaced by the new one
+    for (auto &property : node.getProperties()) {
+        if (property.variable != newProperty.variable)
+            query.statement += "\nREMOVE a." + property.variable;
+    }
+
+    query.parameters["set"] = cypherStringToValue(newProperty.value);
+    query.statement += "\nSET a." + newProperty.variable + "=$set";
+
+    return query;
+}
+
+CypherQuery CypherParser::subgraphQuery(Node root) {
+    CypherQuery query;
+    query.parameters["id"] = root.getId();
+
+    // DISTINCT end nodes let neo4j prune the variable length expansion
+    // instead of enumerating every path
+    query.statement =
+        "MATCH (root:" + STEP_ENTITY_LABEL + "{Id:$id})\n"
+        "OPTIONAL MATCH (root)-[*]->(d)\n"
+        "WITH root, collect(DISTINCT d) AS descendants\n"
+        "UNWIND [root] + [d IN descendants WHERE d <> root] AS a\n"
+        "OPTIONAL MATCH (a)-[r]->(b)\n"
+        "RETURN a, labels(a), collect([type(r), b.Id])";
+
+    return query;
+}
+
+CypherQuery CypherParser::prepareBranchQuery(Node firstCommit,
+                                             std::string branch) {
+    CypherQuery query;
+    query.parameters["branch"] = branch;
+
+    firstCommit.setVariable("f");
+    query.statement =
+        "MERGE (" + firstCommit.toCypher(query.parameters, "f") + ")\n"
+        "MERGE (b:" + BRANCH_LABEL + "{name:$branch})\n"
+        "WITH f, b WHERE NOT (b)-[:" + HEAD_RELATION + "]->()\n"
+        "CREATE (b)-[:" + HEAD_RELATION + "]->(f)";
+
+    return query;
+}
+
+CypherQuery CypherParser::branchHeadQuery(std::string branch) {
+    CypherQuery query;
+    query.parameters["branch"] = branch;
+    query.statement = "MATCH (:" + BRANCH_LABEL + "{name:$branch})-[:" +
+                      HEAD_RELATION + "]->(c) RETURN c.Id";
+    return query;
+}
+
+CypherQuery CypherParser::setBranchHeadQuery(std::string branch,
+                                             std::string id) {
+    CypherQuery query;
+    query.parameters["branch"] = branch;
+    query.parameters["id"] = id;
+    query.statement =
+        "MERGE (b:" + BRANCH_LABEL + "{name:$branch})\n"
+        "WITH b OPTIONAL MATCH (b)-[h:" + HEAD_RELATION + "]->()\n"
+        "DELETE h\n"
+        "WITH DISTINCT b MATCH (c:" + STEP_ENTITY_LABEL + "{Id:$id})\n"
+        "CREATE (b)-[:" + HEAD_RELATION + "]->(c)";
+    return query;
+}
+
+CypherQuery CypherParser::commitQuery(Node commit, std::string branch) {
+    CypherQuery query;
+    query.parameters["branch"] = branch;
+
+    // writing the branch node first locks it, so concurrent commits see the
+    // HEAD moved by the previous one
+    commit.setVariable("c");
+    query.statement =
+        "MATCH (b:" + BRANCH_LABEL + "{name:$branch})\n"
+        "SET b.commits = coalesce(b.commits, 0) + 1\n"
+        "WITH b MATCH (b)-[h:" + HEAD_RELATION + "]->(parent)\n"
+        "CREATE (" + commit.toCypher(query.parameters, "c") + ")\n"
+        "CREATE (parent)-[:" + branch + "]->(c)\n"
+        "DELETE h\n"
+        "CREATE (b)-[:" + HEAD_RELATION + "]->(c)\n"
+        "RETURN parent.Id";
+
+    return query;
+}
+
+CypherQuery CypherParser::commitPathQuery(Node firstCommit,
+                                          std::string branch) {
+    CypherQuery query;
+
+    firstCommit.setVariable("f");
+    query.statement =
+        "MATCH p = (" + firstCommit.toCypher(query.parameters, "f") +
+        ")-[:" + branch + "*]->(c)\n"
+        "WHERE $label IN labels(c)\n"
+        "WITH p ORDER BY length(p) LIMIT 1\n"
+        "RETURN [n IN tail(nodes(p)) | n.Id]";
+
+    return query;
+}
+
+std::string CypherParser::createSnapshotQuery() {
+    return "UNWIND $parts AS p CREATE (:" + SNAPSHOT_LABEL +
+           "{commit:$commit, part:p.part, data:p.data})";
+}
+
+std::string CypherParser::snapshotCommitsQuery() {
+    return "MATCH (s:" + SNAPSHOT_LABEL +
+           ") WHERE s.commit IN $ids RETURN DISTINCT s.commit";
+}
+
+std::string CypherParser::snapshotPartsQuery() {
+    return "MATCH (s:" + SNAPSHOT_LABEL +
+           "{commit:$commit}) RETURN s.data ORDER BY s.part";
+}
@@ -12,11 +12,17 @@
 #include "Tools.hpp"
 #include "TypesNeo4j.h"
 
-struct EntityInfo {
-    std::string name;
-    std::string fileId;
+// statement text and the values it refers to ($parameter)
+// the text no longer depends on the values, so neo4j can reuse its plan
+struct CypherQuery {
+    std::string statement;
+    json parameters = json::object();
 };
 
+// rows passed to a single UNWIND statement (bulk queries), larger lists are
+// split into several statements
+const size_t ROWS_PER_STATEMENT = 10000;
+
 class CypherParser {
    public:
     CypherParser();
@@ -29,6 +35,30 @@ class CypherParser {
     // CREATE(node)
     std::string createNodeQuery(Node node);
 
+    // UNWIND $rows AS r CREATE (n:label:StepEntity) SET n = r
+    // creates all nodes of one label with a single statement
+    std::string createNodesQuery(std::string label);
+
+    // UNWIND $rows AS r MATCH (a:StepEntity{Id:r.from}),(b:...{Id:r.to})
+    // CREATE (a)-[:relation]->(b)
+    // creates all relations of one type with a single statement
+    std::string createRelationsQuery(std::string relation);
+
+    // UNWIND $rows AS r MERGE (n:StepEntity{Id:r.Id}) SET n:label, n = r
+    // creates the nodes that do not exist, replaces the properties of the
+    // existing ones
+    std::string mergeNodesQuery(std::string label);
+
+    // same as createRelationsQuery, but relations that already exist are
+    // not created again (MERGE)
+    std::string mergeRelationsQuery(std::string relation);
+
+    // UNWIND $ids AS id MATCH (n:StepEntity{Id:id}) DETACH DELETE n
+    std::string deleteNodesQuery();
+
+    // UNWIND $ids AS id MATCH (n:StepEntity{Id:id}) SET n.variable = $value
+    std::string setPropertyQuery(std::string variable);
+
     // MATCH(from) RETURN ret
     std::string matchQuery(Node from, std::string ret = "");
 
@@ -51,4 +81,52 @@ class CypherParser {
     // returns a string that can be used in a cypher query to specify the depth
     // of a relation
     std::string depthString(std::string variable, int depth);
+
+    // Parameterized variants of the queries above
+    // property values are passed as parameters instead of being inlined
+    CypherQuery createRelationParameterized(Node from, Node to,
+                                            std::string relation);
+    CypherQuery createNodeQueryParameterized(Node node);
+    CypherQuery matchQueryParameterized(Node from, std::string ret = "");
+    CypherQuery matchQueryParameterized(Node from, std::string relation,
+                                        Node to, std::string ret = "");
+    CypherQuery conditionQueryParameterized(Node node, Property condition,
+                                            std::string ret);
+    CypherQuery deleteQueryParameterized(Node node);
+    CypherQuery modifyNodeQueryParameterized(Node node, Node modified);
+    CypherQuery modifyNodeQueryParameterized(Node node, Property newProperty);
+
+    // all nodes reachable from root (each once, root first) and their
+    // outgoing relations, which all stay inside the subgraph
+    // row: properties, labels, relation types, target ids
+    CypherQuery subgraphQuery(Node root);
+
+    // creates the first commit and the branch with HEAD pointing to the first
+    // commit, if they do not exist yet
+    CypherQuery prepareBranchQuery(Node firstCommit, std::string branch);
+
+    // MATCH (:Branch{name:$branch})-[:HEAD]->(c) RETURN c.Id
+    CypherQuery branchHeadQuery(std::string branch);
+
+    // moves HEAD of the branch (created if missing) to the node with the id
+    CypherQuery setBranchHeadQuery(std::string branch, std::string id);
+
+    // creates the commit, links it to the HEAD of the branch (relation named
+    // after the branch) and moves HEAD to it
+    // row: id of the previous HEAD
+    CypherQuery commitQuery(Node commit, std::string branch);
+
+    // commits of the branch from the first commit (excluded) to the first
+    // commit with the label $label
+    // row: list of commit ids
+    CypherQuery commitPathQuery(Node firstCommit, std::string branch);
+
+    // UNWIND $parts AS p CREATE (:Snapshot{commit:$commit, part:p.part, ...})
+    std::string createSnapshotQuery();
+
+    // commits of $ids that have a snapshot, row: commit id
+    std::string snapshotCommitsQuery();
+
+    // parts of the snapshot of $commit in order, row: data
+    std::string snapshotPartsQuery();
 };
\ No newline at end of file
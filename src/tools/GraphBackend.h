@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TypesNeo4j.h"
+
+/**
+ * @brief GraphBackend
+ * storage interface used by Graph instead of the Neo4j REST endpoint
+ * nodes are matched like a cypher pattern: label, Id and properties of the
+ * given node have to be equal (property values may be cypher strings)
+**/
+
+class GraphBackend {
+   public:
+    virtual ~GraphBackend() {}
+
+    // deletes all nodes and relations
+    virtual void clear() = 0;
+
+    virtual void createNode(Node node) = 0;
+
+    // links every node matching "from" with every node matching "to"
+    virtual void createRelation(Node from, Node to,
+                                const std::string &relation) = 0;
+
+    // deletes the matching nodes including their relations
+    virtual void deleteNodes(Node node) = 0;
+
+    // sets the properties of "modified" on all matching nodes
+    virtual void modifyNodes(Node node, Node modified) = 0;
+
+    // replaces the matched properties of the nodes by the new property
+    virtual void replaceProperty(Node node, const Property &newProperty) = 0;
+
+    virtual std::vector<Node> matchNodes(Node node) = 0;
+
+    // distinct labels, sorted
+    virtual std::vector<std::string> getLabels() = 0;
+
+    virtual std::vector<Node> getAllNodes() = 0;
+    virtual std::vector<Relation> getAllRelations() = 0;
+
+    // direct children of the matching nodes and the relation leading to them
+    virtual std::vector<std::pair<Node, std::string>> getChildren(
+        Node node) = 0;
+
+    // all nodes reachable from / leading to the matching nodes
+    virtual std::vector<Node> getDescendants(Node node) = 0;
+    virtual std::vector<Node> getAncestors(Node node) = 0;
+
+    virtual size_t countNodes() = 0;
+    virtual size_t countRelations() = 0;
+};
@@ -0,0 +1,195 @@
+#include "ImportCsv.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+#include "DatabaseError.hpp"
+
+namespace {
+// rows of a file are written once its buffer exceeds this size, all buffers
+// are written once their total size exceeds the limit
+constexpr size_t FILE_BUFFER_SIZE = 1 << 20;
+constexpr size_t TOTAL_BUFFER_SIZE = 64 << 20;
+
+const std::string ARRAY_DELIMITER = ";";
+
+// quoted csv field, an empty quoted field is an empty string while an empty
+// unquoted field is no property
+std::string quote(const std::string &value) {
+    std::string field = "\"";
+    for (char c : value) {
+        if (c == '"') field += '"';
+        field += c;
+    }
+    return field + "\"";
+}
+
+bool isNumber(const std::string &str) {
+    size_t start = !str.empty() && str[0] == '-' ? 1 : 0;
+    return str.size() > start &&
+           std::all_of(str.begin() + start, str.end(),
+                       [](unsigned char c) { return std::isdigit(c); });
+}
+}  // namespace
+
+ImportCsvWriter::ImportCsvWriter(std::filesystem::path directory)
+    : m_nodeDirectory(directory / "nodes"),
+      m_relationDirectory(directory / "relations") {
+    std::filesystem::create_directories(m_nodeDirectory);
+    std::filesystem::create_directories(m_relationDirectory);
+}
+
+ImportCsvWriter::~ImportCsvWriter() {}
+
+void ImportCsvWriter::writeNode(Node node) {
+    std::string label = node.getLabel();
+    std::string name = label.empty() ? STEP_ENTITY_LABEL : label;
+
+    CsvFile &file =
+        getFile(m_nodeFiles, m_nodeDirectory, name, {"Id:ID", ":LABEL"});
+
+    std::vector<std::string> row(file.columns.size());
+    row[0] = quote(node.getId());
+    row[1] = label.empty() ? STEP_ENTITY_LABEL
+                           : label + ARRAY_DELIMITER + STEP_ENTITY_LABEL;
+
+    // same values as the bulk ingest, all properties are strings
+    for (auto &property : node.getProperties()) {
+        size_t column = getColumn(file, property.variable, "");
+        if (column >= row.size()) row.resize(column + 1);
+        row[column] = quote(cypherStringToValue(property.value));
+    }
+
+    appendRow(file, row);
+    ++m_numNodes;
+}
+
+void ImportCsvWriter::writeRelation(const std::string &fromId,
+                                    const std::string &toId,
+                                    const std::string &relation) {
+    std::vector<Property> properties;
+    std::string type = splitRelation(relation, properties);
+
+    CsvFile &file = getFile(m_relationFiles, m_relationDirectory, type,
+                            {":START_ID", ":END_ID", ":TYPE"});
+
+    std::vector<std::string> row(file.columns.size());
+    row[0] = quote(fromId);
+    row[1] = quote(toId);
+    row[2] = type;
+
+    // e.g. num: 0 is an integer like in the cypher statement
+    for (auto &property : properties) {
+        bool number = isNumber(property.value);
+        size_t column =
+            getColumn(file, property.variable, number ? "long" : "");
+
+        if (column >= row.size()) row.resize(column + 1);
+        row[column] = number ? property.value
+                             : quote(cypherStringToValue(property.value));
+    }
+
+    appendRow(file, row);
+    ++m_numRelations;
+}
+
+void ImportCsvWriter::finish() {
+    flushAll();
+
+    for (auto *files : {&m_nodeFiles, &m_relationFiles}) {
+        for (auto &[name, file] : *files) {
+            std::string header;
+            for (size_t i = 0; i < file.columns.size(); ++i) {
+                if (i > 0) header += ',';
+                header += file.columns[i];
+            }
+
+            std::ofstream out(file.header, std::ios::binary | std::ios::trunc);
+            out << header << '\n';
+            if (!out)
+                throw_database_error("failed to write " +
+                                     file.header.string());
+        }
+    }
+}
+
+std::string ImportCsvWriter::importArguments() {
+    std::string arguments;
+
+    for (auto &[name, file] : m_nodeFiles)
+        arguments += " --nodes=" + file.header.string() + "," +
+                     file.data.string();
+
+    for (auto &[name, file] : m_relationFiles)
+        arguments += " --relationships=" + file.header.string() + "," +
+                     file.data.string();
+
+    return "--array-delimiter=\"" + ARRAY_DELIMITER + "\"" + arguments;
+}
+
+ImportCsvWriter::CsvFile &ImportCsvWriter::getFile(
+    std::map<std::string, CsvFile> &files,
+    const std::filesystem::path &directory, const std::string &name,
+    const std::vector<std::string> &fixedColumns) {
+    auto it = files.find(name);
+    if (it != files.end()) return it->second;
+
+    CsvFile &file = files[name];
+    file.data = directory / (name + ".csv");
+    file.header = directory / (name + "_header.csv");
+    file.columns = fixedColumns;
+    return file;
+}
+
+size_t ImportCsvWriter::getColumn(CsvFile &file, const std::string &property,
+                                  const std::string &type) {
+    auto it = file.columnIndex.find(property);
+    if (it != file.columnIndex.end()) return it->second;
+
+    // columns found later are appended, the rows written before simply end
+    // earlier (no value)
+    size_t index = file.columns.size();
+    file.columns.push_back(type.empty() ? property : property + ":" + type);
+    file.columnIndex[property] = index;
+    return index;
+}
+
+void ImportCsvWriter::appendRow(CsvFile &file,
+                                const std::vector<std::string> &row) {
+    size_t size = file.buffer.size();
+
+    for (size_t i = 0; i < row.size(); ++i) {
+        if (i > 0) file.buffer += ',';
+        file.buffer += row[i];
+    }
+    file.buffer += '\n';
+
+    m_buffered += file.buffer.size() - size;
+
+    if (file.buffer.size() >= FILE_BUFFER_SIZE)
+        flush(file);
+    else if (m_buffered >= TOTAL_BUFFER_SIZE)
+        flushAll();
+}
+
+void ImportCsvWriter::flush(CsvFile &file) {
+    if (file.buffer.empty() && file.created) return;
+
+    // the first write replaces the file of a previous export
+    auto mode = std::ios::binary |
+                (file.created ? std::ios::app : std::ios::trunc);
+    std::ofstream out(file.data, mode);
+    out.write(file.buffer.data(), file.buffer.size());
+
+    if (!out) throw_database_error("failed to write " + file.data.string());
+
+    m_buffered -= file.buffer.size();
+    file.buffer.clear();
+    file.created = true;
+}
+
+void ImportCsvWriter::flushAll() {
+    for (auto &[name, file] : m_nodeFiles) flush(file);
+    for (auto &[name, file] : m_relationFiles) flush(file);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TypesNeo4j.h"
+
+/**
+ * @brief ImportCsv
+ * writes nodes and relations as csv files for neo4j-admin database import
+ * one file per label (nodes) and per relation type, the header of every file
+ * is written to a separate file at the end, so the rows can be streamed to
+ * disk while the columns are still being collected
+**/
+
+class ImportCsvWriter {
+   public:
+    // files are written to <directory>/nodes and <directory>/relations
+    explicit ImportCsvWriter(std::filesystem::path directory);
+    ~ImportCsvWriter();
+
+    void writeNode(Node node);
+
+    // relation e.g. "name" or "entry{num: 0}" (type with properties)
+    void writeRelation(const std::string &fromId, const std::string &toId,
+                       const std::string &relation);
+
+    // writes the remaining rows and the header files
+    void finish();
+
+    // arguments of neo4j-admin database import for the written files
+    // (--nodes=... --relationships=...)
+    std::string importArguments();
+
+    size_t getNumNodes() { return m_numNodes; }
+    size_t getNumRelations() { return m_numRelations; }
+
+   private:
+    struct CsvFile {
+        std::filesystem::path data;
+        std::filesystem::path header;
+
+        // header fields (e.g. "Id:ID", "num:long")
+        std::vector<std::string> columns;
+        // property name -> index of the column
+        std::unordered_map<std::string, size_t> columnIndex;
+
+        // rows not written to disk yet
+        std::string buffer;
+        bool created = false;
+    };
+
+    CsvFile &getFile(std::map<std::string, CsvFile> &files,
+                     const std::filesystem::path &directory,
+                     const std::string &name,
+                     const std::vector<std::string> &fixedColumns);
+
+    // index of the column of a property, appended if it is new
+    size_t getColumn(CsvFile &file, const std::string &property,
+                     const std::string &type);
+
+    void appendRow(CsvFile &file, const std::vector<std::string> &row);
+
+    // appends the buffered rows to the data file
+    void flush(CsvFile &file);
+    void flushAll();
+
+    std::filesystem::path m_nodeDirectory;
+    std::filesystem::path m_relationDirectory;
+
+    // by label and relation type
+    std::map<std::string, CsvFile> m_nodeFiles;
+    std::map<std::string, CsvFile> m_relationFiles;
+
+    // bytes of all buffers
+    size_t m_buffered = 0;
+
+    size_t m_numNodes = 0;
+    size_t m_numRelations = 0;
+};
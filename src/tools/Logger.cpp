@@ -2,12 +2,17 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
 namespace fs = std::filesystem;
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+// Graphs may be created concurrently (async addon workers)
+static std::mutex loggerMutex;
+
 void Logger::initializeLogger(std::string file) {
+    std::lock_guard<std::mutex> lock(loggerMutex);
     try {
         file = fs::current_path().string() + "/Log/" + file;
         spdlog::drop_all();
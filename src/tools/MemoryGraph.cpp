@@ -0,0 +1,347 @@
+#include "MemoryGraph.h"
+
+#include <algorithm>
+#include <map>
+
+MemoryGraph::MemoryGraph() {}
+
+MemoryGraph::~MemoryGraph() {}
+
+std::shared_ptr<MemoryGraph> MemoryGraph::getStore(const std::string &name) {
+    static std::mutex storesMutex;
+    static std::map<std::string, std::shared_ptr<MemoryGraph>> stores;
+
+    std::lock_guard<std::mutex> lock(storesMutex);
+    auto &store = stores[name];
+    if (!store) store = std::make_shared<MemoryGraph>();
+
+    return store;
+}
+
+void MemoryGraph::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_ids.clear();
+    m_labels.clear();
+    m_properties.clear();
+    m_nodeAlive.clear();
+    m_outgoing.clear();
+    m_incoming.clear();
+    m_numNodes = 0;
+
+    m_edgeFrom.clear();
+    m_edgeTo.clear();
+    m_edgeTypes.clear();
+    m_edgeProperties.clear();
+    m_edgeAlive.clear();
+    m_numEdges = 0;
+
+    m_idIndex.clear();
+    for (auto &nodes : m_labelIndex) nodes.clear();
+}
+
+void MemoryGraph::createNode(Node node) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint32_t index = m_ids.size();
+    uint32_t label = internLabel(node.getLabel());
+
+    m_ids.push_back(node.getId());
+    m_labels.push_back(label);
+    m_properties.emplace_back();
+    m_nodeAlive.push_back(true);
+    m_outgoing.emplace_back();
+    m_incoming.emplace_back();
+    ++m_numNodes;
+
+    for (auto &property : node.getProperties())
+        setProperty(index, property.variable, property.value);
+
+    if (!node.getId().empty()) m_idIndex[node.getId()] = index;
+    m_labelIndex[label].push_back(index);
+}
+
+void MemoryGraph::createRelation(Node from, Node to,
+                                 const std::string &relation) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // the type only, like TYPE(r) of Neo4j
+    std::vector<Property> properties;
+    uint32_t type = internRelation(splitRelation(relation, properties));
+    for (auto &property : properties)
+        property.value = cypherStringToValue(property.value);
+
+    std::vector<uint32_t> targets = match(to);
+
+    for (auto &source : match(from)) {
+        for (auto &target : targets) {
+            uint32_t edge = m_edgeFrom.size();
+            m_edgeFrom.push_back(source);
+            m_edgeTo.push_back(target);
+            m_edgeTypes.push_back(type);
+            m_edgeProperties.push_back(properties);
+            m_edgeAlive.push_back(true);
+            m_outgoing[source].push_back(edge);
+            m_incoming[target].push_back(edge);
+            ++m_numEdges;
+        }
+    }
+}
+
+void MemoryGraph::deleteNodes(Node node) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto &index : match(node)) {
+        // detach delete
+        for (auto *edges : {&m_outgoing[index], &m_incoming[index]}) {
+            for (auto &edge : *edges) {
+                if (m_edgeAlive[edge]) {
+                    m_edgeAlive[edge] = false;
+                    --m_numEdges;
+                }
+            }
+            edges->clear();
+        }
+
+        auto it = m_idIndex.find(m_ids[index]);
+        if (it != m_idIndex.end() && it->second == index) m_idIndex.erase(it);
+
+        m_properties[index].clear();
+        m_nodeAlive[index] = false;
+        --m_numNodes;
+    }
+}
+
+void MemoryGraph::modifyNodes(Node node, Node modified) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Property> properties = modified.getProperties();
+
+    for (auto &index : match(node)) {
+        for (auto &property : properties)
+            setProperty(index, property.variable, property.value);
+    }
+}
+
+void MemoryGraph::replaceProperty(Node node, const Property &newProperty) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Property> matched = node.getProperties();
+
+    for (auto &index : match(node)) {
+        auto &properties = m_properties[index];
+        for (auto &property : matched) {
+            if (property.variable == newProperty.variable) continue;
+
+            std::erase_if(properties, [&property](const Property &entry) {
+                return entry.variable == property.variable;
+            });
+        }
+        setProperty(index, newProperty.variable, newProperty.value);
+    }
+}
+
+std::vector<Node> MemoryGraph::matchNodes(Node node) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Node> nodes;
+    for (auto &index : match(node)) nodes.push_back(toNode(index));
+
+    return nodes;
+}
+
+std::vector<std::string> MemoryGraph::getLabels() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::string> labels;
+    for (uint32_t label = 0; label < m_labelIndex.size(); ++label) {
+        if (m_labelNames[label].empty()) continue;
+
+        for (auto &index : m_labelIndex[label]) {
+            if (m_nodeAlive[index]) {
+                labels.push_back(m_labelNames[label]);
+                break;
+            }
+        }
+    }
+
+    std::sort(labels.begin(), labels.end());
+    return labels;
+}
+
+std::vector<Node> MemoryGraph::getAllNodes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Node> nodes;
+    nodes.reserve(m_numNodes);
+    for (uint32_t index = 0; index < m_ids.size(); ++index) {
+        if (m_nodeAlive[index]) nodes.push_back(toNode(index));
+    }
+    return nodes;
+}
+
+std::vector<Relation> MemoryGraph::getAllRelations() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Relation> relations;
+    relations.reserve(m_numEdges);
+    for (uint32_t edge = 0; edge < m_edgeFrom.size(); ++edge) {
+        if (!m_edgeAlive[edge]) continue;
+
+        relations.push_back({.nodeIdFrom = m_ids[m_edgeFrom[edge]],
+                             .nodeIdTo = m_ids[m_edgeTo[edge]],
+                             .relation = m_relationNames[m_edgeTypes[edge]]});
+    }
+    return relations;
+}
+
+std::vector<std::pair<Node, std::string>> MemoryGraph::getChildren(Node node) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::pair<Node, std::string>> children;
+    for (auto &index : match(node)) {
+        for (auto &edge : m_outgoing[index]) {
+            if (!m_edgeAlive[edge]) continue;
+
+            children.push_back(std::make_pair(
+                toNode(m_edgeTo[edge]), m_relationNames[m_edgeTypes[edge]]));
+        }
+    }
+    return children;
+}
+
+std::vector<Node> MemoryGraph::getDescendants(Node node) {
+    return traverse(node, true);
+}
+
+std::vector<Node> MemoryGraph::getAncestors(Node node) {
+    return traverse(node, false);
+}
+
+size_t MemoryGraph::countNodes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numNodes;
+}
+
+size_t MemoryGraph::countRelations() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numEdges;
+}
+
+std::vector<uint32_t> MemoryGraph::match(Node &node) {
+    std::vector<uint32_t> matches;
+
+    // candidates: by id, by label or all nodes
+    if (!node.getId().empty()) {
+        auto it = m_idIndex.find(node.getId());
+        if (it != m_idIndex.end() && matchesProperties(it->second, node))
+            matches.push_back(it->second);
+
+        return matches;
+    }
+
+    if (!node.getLabel().empty()) {
+        auto label = m_labelIds.find(node.getLabel());
+        if (label == m_labelIds.end()) return matches;
+
+        for (auto &index : m_labelIndex[label->second]) {
+            if (matchesProperties(index, node)) matches.push_back(index);
+        }
+        return matches;
+    }
+
+    for (uint32_t index = 0; index < m_ids.size(); ++index) {
+        if (matchesProperties(index, node)) matches.push_back(index);
+    }
+    return matches;
+}
+
+bool MemoryGraph::matchesProperties(uint32_t index, Node &node) {
+    if (!m_nodeAlive[index]) return false;
+
+    if (!node.getLabel().empty() &&
+        m_labelNames[m_labels[index]] != node.getLabel())
+        return false;
+
+    for (auto &property : node.getProperties()) {
+        std::string value = cypherStringToValue(property.value);
+
+        auto &properties = m_properties[index];
+        auto it = std::find_if(properties.begin(), properties.end(),
+                               [&property](const Property &entry) {
+                                   return entry.variable == property.variable;
+                               });
+        if (it == properties.end() || it->value != value) return false;
+    }
+    return true;
+}
+
+std::vector<Node> MemoryGraph::traverse(Node node, bool outgoing) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Node> nodes;
+    std::vector<bool> visited(m_ids.size(), false);
+    std::vector<uint32_t> queue = match(node);
+
+    // relations of at least one hop, each node is returned once
+    for (size_t current = 0; current < queue.size(); ++current) {
+        uint32_t index = queue[current];
+        auto &edges = outgoing ? m_outgoing[index] : m_incoming[index];
+
+        for (auto &edge : edges) {
+            if (!m_edgeAlive[edge]) continue;
+
+            uint32_t next = outgoing ? m_edgeTo[edge] : m_edgeFrom[edge];
+            if (visited[next]) continue;
+
+            visited[next] = true;
+            nodes.push_back(toNode(next));
+            queue.push_back(next);
+        }
+    }
+    return nodes;
+}
+
+Node MemoryGraph::toNode(uint32_t index) {
+    Node node(m_ids[index]);
+    node.setLabel(m_labelNames[m_labels[index]]);
+    node.setProperties(m_properties[index]);
+    return node;
+}
+
+uint32_t MemoryGraph::internLabel(const std::string &label) {
+    auto it = m_labelIds.find(label);
+    if (it != m_labelIds.end()) return it->second;
+
+    m_labelNames.push_back(label);
+    m_labelIndex.emplace_back();
+    m_labelIds[label] = m_labelNames.size() - 1;
+    return m_labelNames.size() - 1;
+}
+
+uint32_t MemoryGraph::internRelation(const std::string &relation) {
+    auto it = m_relationIds.find(relation);
+    if (it != m_relationIds.end()) return it->second;
+
+    m_relationNames.push_back(relation);
+    m_relationIds[relation] = m_relationNames.size() - 1;
+    return m_relationNames.size() - 1;
+}
+
+void MemoryGraph::setProperty(uint32_t index, const std::string &variable,
+                              const std::string &value) {
+    auto &properties = m_properties[index];
+
+    // values are stored like the parameters sent to Neo4j (without quotes)
+    std::string plainValue = cypherStringToValue(value);
+
+    for (auto &property : properties) {
+        if (property.variable == variable) {
+            property.value = plainValue;
+            return;
+        }
+    }
+
+    properties.push_back({.variable = variable, .value = plainValue});
+    sortProperties(properties);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "GraphBackend.h"
+
+// prefix of DatabaseInfo::hostName that selects the in-memory backend
+const std::string MEMORY_HOST = "memory://";
+
+/**
+ * @brief MemoryGraph
+ * in-process graph store, no database server required
+ * nodes and relations are kept in flat arrays (one entry per node/edge),
+ * labels and relation types are interned, deleted entries are only marked
+ * relation strings like "entry{num: 0}" are split into the type and edge
+ * properties, as Neo4j does for the same pattern
+ * stores are shared process-wide by their name (see getStore)
+**/
+
+class MemoryGraph : public GraphBackend {
+   public:
+    MemoryGraph();
+    ~MemoryGraph();
+
+    // returns the store with the given name, creates it on first use
+    static std::shared_ptr<MemoryGraph> getStore(const std::string &name);
+
+    void clear() override;
+
+    void createNode(Node node) override;
+    void createRelation(Node from, Node to,
+                        const std::string &relation) override;
+    void deleteNodes(Node node) override;
+    void modifyNodes(Node node, Node modified) override;
+    void replaceProperty(Node node, const Property &newProperty) override;
+
+    std::vector<Node> matchNodes(Node node) override;
+    std::vector<std::string> getLabels() override;
+    std::vector<Node> getAllNodes() override;
+    std::vector<Relation> getAllRelations() override;
+
+    std::vector<std::pair<Node, std::string>> getChildren(Node node) override;
+    std::vector<Node> getDescendants(Node node) override;
+    std::vector<Node> getAncestors(Node node) override;
+
+    size_t countNodes() override;
+    size_t countRelations() override;
+
+   private:
+    // indices of the nodes matching the pattern
+    std::vector<uint32_t> match(Node &node);
+    bool matchesProperties(uint32_t index, Node &node);
+
+    // breadth first search along outgoing (or incoming) edges
+    std::vector<Node> traverse(Node node, bool outgoing);
+
+    Node toNode(uint32_t index);
+    uint32_t internLabel(const std::string &label);
+    uint32_t internRelation(const std::string &relation);
+    void setProperty(uint32_t index, const std::string &variable,
+                     const std::string &value);
+
+    std::mutex m_mutex;
+
+    // nodes
+    std::vector<std::string> m_ids;
+    std::vector<uint32_t> m_labels;
+    std::vector<std::vector<Property>> m_properties;
+    std::vector<bool> m_nodeAlive;
+    std::vector<std::vector<uint32_t>> m_outgoing;
+    std::vector<std::vector<uint32_t>> m_incoming;
+    size_t m_numNodes = 0;
+
+    // edges
+    std::vector<uint32_t> m_edgeFrom;
+    std::vector<uint32_t> m_edgeTo;
+    std::vector<uint32_t> m_edgeTypes;
+    std::vector<std::vector<Property>> m_edgeProperties;
+    std::vector<bool> m_edgeAlive;
+    size_t m_numEdges = 0;
+
+    // lookup tables
+    std::unordered_map<std::string, uint32_t> m_idIndex;
+    std::vector<std::vector<uint32_t>> m_labelIndex;
+    std::vector<std::string> m_labelNames;
+    std::unordered_map<std::string, uint32_t> m_labelIds;
+    std::vector<std::string> m_relationNames;
+    std::unordered_map<std::string, uint32_t> m_relationIds;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief ParallelFor
+ * runs a function for every index of a range on a set of worker threads
+ * every worker starts with an equal share of the range, a worker that runs
+ * out of work steals the upper half of the remaining share of another one
+**/
+
+// number of worker threads used by default (hardware threads)
+inline size_t parallelWorkers() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// calls func(index) for all indices in [0, count), returns when all calls
+// are finished. The first exception thrown by func is rethrown.
+template <typename Func>
+void parallelFor(size_t count, Func func,
+                 size_t numWorkers = parallelWorkers()) {
+    numWorkers = std::min(numWorkers, count);
+
+    if (numWorkers <= 1) {
+        for (size_t index = 0; index < count; ++index) func(index);
+        return;
+    }
+
+    // remaining indices [begin, end) of a worker
+    struct Share {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    std::vector<Share> shares(numWorkers);
+    for (size_t worker = 0; worker < numWorkers; ++worker) {
+        shares[worker].begin = count * worker / numWorkers;
+        shares[worker].end = count * (worker + 1) / numWorkers;
+    }
+
+    std::atomic<bool> failed = false;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    // takes the next index of the own share
+    auto next = [&shares](size_t worker, size_t &index) {
+        Share &share = shares[worker];
+        std::lock_guard<std::mutex> lock(share.mutex);
+        if (share.begin == share.end) return false;
+
+        index = share.begin++;
+        return true;
+    };
+
+    // moves the upper half of another share to the own (empty) share
+    auto steal = [&shares, numWorkers](size_t worker) {
+        for (size_t offset = 1; offset < numWorkers; ++offset) {
+            Share &victim = shares[(worker + offset) % numWorkers];
+
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.begin == victim.end) continue;
+
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+
+            Share &own = shares[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+        return false;
+    };
+
+    auto run = [&](size_t worker) {
+        size_t index;
+        while (!failed) {
+            if (!next(worker, index)) {
+                if (!steal(worker)) return;
+                continue;
+            }
+
+            try {
+                func(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    // the calling thread is the first worker
+    std::vector<std::thread> threads;
+    for (size_t worker = 1; worker < numWorkers; ++worker)
+        threads.emplace_back(run, worker);
+    run(0);
+
+    for (auto &thread : threads) thread.join();
+
+    if (error) std::rethrow_exception(error);
+}
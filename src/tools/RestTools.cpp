@@ -23,6 +23,46 @@ void RestInterface::setCredentials(const std::string& username,
     std::string credentials = m_username + ":" + m_password;
 
     m_base64Credentials = base64Encode(credentials);
+    resetSessions();
+}
+
+std::unique_ptr<cpr::Session> RestInterface::acquireSession(
+    size_t& generation) {
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    generation = m_sessionGeneration;
+
+    if (!m_idleSessions.empty()) {
+        std::unique_ptr<cpr::Session> session =
+            std::move(m_idleSessions.back());
+        m_idleSessions.pop_back();
+        return session;
+    }
+
+    auto session = std::make_unique<cpr::Session>();
+    session->SetUrl(cpr::Url{m_host + m_path});
+
+    cpr::Header header{{"Content-Type", contentType},
+                       {"Accept", contentType + ";charset=UTF-8"},
+                       {"Access-Mode", "WRITE"},
+                       {"Connection", "keep-alive"}};
+    if (!m_base64Credentials.empty())
+        header["Authorization"] = "Basic " + m_base64Credentials;
+
+    session->SetHeader(header);
+    return session;
+}
+
+void RestInterface::releaseSession(std::unique_ptr<cpr::Session> session,
+                                   size_t generation) {
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    if (generation == m_sessionGeneration)
+        m_idleSessions.push_back(std::move(session));
+}
+
+void RestInterface::resetSessions() {
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    ++m_sessionGeneration;
+    m_idleSessions.clear();
 }
 
 HttpState RestInterface::intToHttpState(const int state) {
@@ -73,23 +113,35 @@ HttpState RestInterface::getRequest(std::string& result) {
     return intToHttpState(response.status_code);
 }
 
+HttpState RestInterface::postRequest(const std::vector<CypherQuery>& queries,
+                                     QueryResponse& response) {
+    // {"statements":[{"statement":...,"parameters":{...}}]}
+    json statements = json::array();
+    for (auto& query : queries)
+        statements.push_back({{"statement", query.statement},
+                              {"parameters", query.parameters}});
+
+    response = QueryResponse();
+    HttpState state =
+        postRequest(json{{"statements", statements}}.dump(), response.json);
+
+    if (response.json.empty())
+        response.errors.push_back(
+            {.code = "Neo.TransientError.General.ConnectionError",
+             .message = "no response from " + m_host + m_path});
+    return state;
+}
+
 HttpState RestInterface::postRequest(const std::string& jsonPayload,
                                      std::string& data) {
-    cpr::Response response;
+    // the session is owned by this request until it is released, so
+    // concurrent requests never share one
+    size_t generation;
+    std::unique_ptr<cpr::Session> session = acquireSession(generation);
+    session->SetBody(cpr::Body{jsonPayload});
 
-    if (!m_base64Credentials.empty()) {
-        response = cpr::Post(
-            cpr::Url{(m_host + m_path)},
-            cpr::Header{{"Authorization", "Basic " + m_base64Credentials},
-                        {"Content-Type", contentType},
-                        {"Accept", contentType + ";charset=UTF-8"},
-                        {"Access-Mode", "WRITE"}},
-            cpr::Body{jsonPayload});
-
-    } else {
-        response =
-            cpr::Post(cpr::Url{m_host + (m_path)}, cpr::Body{jsonPayload});
-    }
+    cpr::Response response = session->Post();
+    releaseSession(std::move(session), generation);
 
     data = response.text;
     return intToHttpState(response.status_code);
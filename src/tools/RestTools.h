@@ -1,10 +1,22 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CypherParser.h"
+#include "ResultDecoder.h"
+
 /**
  * @brief RestTools
  * used for sending queries to the neo4j database via the rest api
 **/
 
+namespace cpr {
+class Session;
+}
+
 enum class HttpState {
     HTTP_OK = 200,
     HTTP_CREATED = 201,
@@ -47,7 +59,24 @@ inline std::string httpStateToStr(const HttpState state) {
 
 enum class AccessMode { WRITE, READ };
 
-class RestInterface {
+/**
+ * @brief Transport
+ * interface used by Graph to send queries to the database
+ * all queries of a request are run in one transaction, the response is
+ * either the json text of the transactional endpoint
+ * {"results":[{"columns":[...],"data":[{"row":[...]}]}],"errors":[...]}
+ * or the decoded rows (see QueryResponse)
+**/
+
+class Transport {
+   public:
+    virtual ~Transport() {}
+
+    virtual HttpState postRequest(const std::vector<CypherQuery>& queries,
+                                  QueryResponse& response) = 0;
+};
+
+class RestInterface : public Transport {
    public:
     RestInterface();
     RestInterface(std::string host, std::string username, std::string password);
@@ -55,6 +84,8 @@ class RestInterface {
     ~RestInterface();
 
     HttpState getRequest(std::string& result);
+    HttpState postRequest(const std::vector<CypherQuery>& queries,
+                          QueryResponse& response) override;
     HttpState postRequest(const std::string& jsonPayload, std::string& data);
     HttpState deleteRequest();
 
@@ -62,19 +93,44 @@ class RestInterface {
 
     void setCredentials(const std::string& username,
                         const std::string& password);
-    void setHost(const std::string& host) { m_host = host; }
-    void setPath(const std::string path) { m_path = path; }
-    
+    void setHost(const std::string& host) {
+        m_host = host;
+        resetSessions();
+    }
+    void setPath(const std::string path) {
+        m_path = path;
+        resetSessions();
+    }
+
     std::string getHost() { return m_host; }
 
    private:
     // converts the statuscode to a string
     HttpState intToHttpState(const int state);
 
+    // takes an idle session (or creates one) for a single request
+    // a session keeps its connection open and is reused by later requests
+    std::unique_ptr<cpr::Session> acquireSession(size_t& generation);
+
+    // returns the session to the idle ones, unless the sessions were reset
+    // while it was in use
+    void releaseSession(std::unique_ptr<cpr::Session> session,
+                        size_t generation);
+
+    // drops the idle sessions, e.g. if the host or the credentials changed
+    // sessions in use are dropped when their request is finished
+    void resetSessions();
+
     AccessMode m_accessMode;  // e.g. READ or WRITE
     std::string m_host;       // e.g. http://localhost:7474/
     std::string m_path;       // e.g. db/neo4j/tx/commit/
     std::string m_username;   // e.g. neo4j
     std::string m_password;
     std::string m_base64Credentials;
+
+    // persistent sessions not in use by a request, at most one per
+    // concurrent request
+    std::mutex m_sessionMutex;
+    std::vector<std::unique_ptr<cpr::Session>> m_idleSessions;
+    size_t m_sessionGeneration = 0;  // incremented by resetSessions
 };
\ No newline at end of file
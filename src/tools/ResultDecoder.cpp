@@ -0,0 +1,261 @@
+#include "ResultDecoder.h"
+
+#include "DatabaseError.hpp"
+
+void ResultDecoder::decode(const std::string &response,
+                           const RowCallback &onRow) {
+    if (response.empty()) return;
+
+    ResultDecoder decoder(onRow);
+    json::sax_parse(response, &decoder);
+}
+
+void ResultDecoder::decode(QueryResponse response, const RowCallback &onRow) {
+    if (!response.json.empty()) return decode(response.json, onRow);
+
+    for (auto &row : response.rows) onRow(row);
+}
+
+void checkResponseForErrors(const QueryResponse &response) {
+    if (!response.json.empty()) {
+        checkResponseForErrors(response.json);
+        return;
+    }
+    if (response.errors.empty()) return;
+
+    // same format as extractErrorMessage
+    std::string message =
+        std::to_string(response.errors.size()) + " errors found: \n";
+    for (size_t i = 0; i < response.errors.size(); ++i) {
+        message += "error[" + std::to_string(i) + "] \n";
+        message += "\tcode: " + json(response.errors[i].code).dump() + "\n";
+        message +=
+            "\tmessage: " + json(response.errors[i].message).dump() + "\n\n";
+    }
+    throw_database_error(message);
+}
+
+bool ResultDecoder::null() {
+    if (m_skipDepth > 0 || m_levels.empty()) return true;
+
+    // null columns are kept as ResultValue::Type::Null
+    if (m_levels.back() == Level::Row)
+        m_row.emplace_back();
+    else
+        value("null", "null");
+    return true;
+}
+
+bool ResultDecoder::boolean(bool value) {
+    std::string text = value ? "true" : "false";
+    this->value(text, text);
+    return true;
+}
+
+bool ResultDecoder::number_integer(number_integer_t value) {
+    std::string text = std::to_string(value);
+    this->value(text, text);
+    return true;
+}
+
+bool ResultDecoder::number_unsigned(number_unsigned_t value) {
+    std::string text = std::to_string(value);
+    this->value(text, text);
+    return true;
+}
+
+bool ResultDecoder::number_float(number_float_t value, const string_t &) {
+    // same format as json::dump()
+    std::string text = json(value).dump();
+    this->value(text, text);
+    return true;
+}
+
+bool ResultDecoder::string(string_t &value) {
+    if (m_skipDepth > 0) return true;
+
+    this->value(json(value).dump(), value);
+    return true;
+}
+
+bool ResultDecoder::binary(binary_t &value) {
+    std::string text = json(value).dump();
+    this->value(text, text);
+    return true;
+}
+
+bool ResultDecoder::start_object(std::size_t) {
+    startContainer(true);
+    return true;
+}
+
+bool ResultDecoder::key(string_t &value) {
+    if (m_skipDepth > 0 || m_levels.empty()) return true;
+
+    switch (m_levels.back()) {
+        case Level::Root:
+        case Level::Result:
+        case Level::Entry:
+            m_key = value;
+            break;
+        case Level::Map:
+            m_row.back().fields.push_back({.variable = value});
+            break;
+        case Level::Nested:
+            if (!m_nestedFirst.back()) m_nested += ',';
+            m_nestedFirst.back() = false;
+            m_nested += json(value).dump() + ":";
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+bool ResultDecoder::end_object() {
+    endContainer();
+    return true;
+}
+
+bool ResultDecoder::start_array(std::size_t) {
+    startContainer(false);
+    return true;
+}
+
+bool ResultDecoder::end_array() {
+    endContainer();
+    return true;
+}
+
+bool ResultDecoder::parse_error(std::size_t, const std::string &,
+                                const nlohmann::detail::exception &error) {
+    throw_database_error(std::string("invalid response: ") + error.what());
+}
+
+void ResultDecoder::value(const std::string &text, const std::string &plain) {
+    if (m_skipDepth > 0 || m_levels.empty()) return;
+
+    switch (m_levels.back()) {
+        case Level::Row: {
+            ResultValue column;
+            column.type = ResultValue::Type::Scalar;
+            column.value = plain;
+            m_row.push_back(std::move(column));
+            break;
+        }
+        case Level::List:
+            m_row.back().entries.push_back(plain);
+            break;
+        case Level::Map:
+            m_row.back().fields.back().value = text;
+            break;
+        case Level::Nested:
+            appendNested(text);
+            break;
+        default:
+            // e.g. "columns", "commit"
+            break;
+    }
+}
+
+void ResultDecoder::startContainer(bool isObject) {
+    if (m_skipDepth > 0) {
+        ++m_skipDepth;
+        return;
+    }
+
+    if (m_levels.empty()) {
+        m_levels.push_back(Level::Root);
+        return;
+    }
+
+    Level next = Level::Nested;
+    bool accepted = true;
+    switch (m_levels.back()) {
+        case Level::Root:
+            accepted = !isObject && m_key == "results";
+            next = Level::Results;
+            break;
+        case Level::Results:
+            accepted = isObject;
+            next = Level::Result;
+            break;
+        case Level::Result:
+            accepted = !isObject && m_key == "data";
+            next = Level::Data;
+            break;
+        case Level::Data:
+            accepted = isObject;
+            next = Level::Entry;
+            break;
+        case Level::Entry:
+            accepted = !isObject && m_key == "row";
+            m_row.clear();
+            next = Level::Row;
+            break;
+        case Level::Row: {
+            ResultValue column;
+            column.type =
+                isObject ? ResultValue::Type::Map : ResultValue::Type::List;
+            m_row.push_back(std::move(column));
+            next = isObject ? Level::Map : Level::List;
+            break;
+        }
+        case Level::List:
+        case Level::Map:
+            m_nested.clear();
+            m_nested += isObject ? '{' : '[';
+            break;
+        case Level::Nested:
+            appendNested(isObject ? "{" : "[");
+            break;
+    }
+
+    if (!accepted) {
+        ++m_skipDepth;
+        return;
+    }
+
+    if (next == Level::Nested) {
+        m_nestedFirst.push_back(true);
+        m_nestedObject.push_back(isObject);
+    }
+    m_levels.push_back(next);
+}
+
+void ResultDecoder::endContainer() {
+    if (m_skipDepth > 0) {
+        --m_skipDepth;
+        return;
+    }
+
+    Level level = m_levels.back();
+    m_levels.pop_back();
+
+    if (level == Level::Row) {
+        m_onRow(m_row);
+        m_row.clear();
+    } else if (level == Level::Map) {
+        // sorted by key like a json object
+        sortProperties(m_row.back().fields);
+    } else if (level == Level::Nested) {
+        m_nested += m_nestedObject.back() ? '}' : ']';
+        m_nestedFirst.pop_back();
+        m_nestedObject.pop_back();
+
+        // the outermost nested value is complete
+        if (m_levels.back() == Level::List)
+            m_row.back().entries.push_back(m_nested);
+        else if (m_levels.back() == Level::Map)
+            m_row.back().fields.back().value = m_nested;
+    }
+}
+
+void ResultDecoder::appendNested(const std::string &text) {
+    // inside objects the comma is added with the key
+    if (!m_nestedObject.back()) {
+        if (!m_nestedFirst.back()) m_nested += ',';
+        m_nestedFirst.back() = false;
+    }
+    m_nested += text;
+}
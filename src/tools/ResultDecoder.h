@@ -0,0 +1,117 @@
+#pragma once
+
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "TypesNeo4j.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief ResultDecoder
+ * streaming (sax) decoder for responses of the transactional endpoint
+ * the rows of all results are decoded one by one while the response is
+ * parsed, no json document of the whole response is built
+ * (bolt responses contain the decoded rows already)
+**/
+
+// value of a column in a result row
+struct ResultValue {
+    enum class Type { Null, Scalar, List, Map };
+
+    Type type = Type::Null;
+
+    // Scalar: strings without quotes, other values as json text
+    std::string value;
+
+    // List: entries in the same format as value (nested values as json text)
+    std::vector<std::string> entries;
+
+    // Map (e.g. the properties of a node): sorted by key, values as json
+    // text, i.e. strings keep their quotes like json::dump()
+    std::vector<Property> fields;
+};
+
+using ResultRow = std::vector<ResultValue>;
+
+struct QueryError {
+    std::string code;  // e.g. Neo.ClientError.Statement.SyntaxError
+    std::string message;
+};
+
+// response of a request (see Transport): the json text of the http
+// endpoint, or the rows of the bolt records decoded while they are received
+struct QueryResponse {
+    std::string json;
+
+    // bolt: rows of all statements, errors of the transaction
+    std::vector<ResultRow> rows;
+    std::vector<QueryError> errors;
+};
+
+// throws the errors of the response (DatabaseError)
+void checkResponseForErrors(const QueryResponse &response);
+
+class ResultDecoder : public nlohmann::json_sax<json> {
+   public:
+    using RowCallback = std::function<void(ResultRow &row)>;
+
+    // calls onRow for every row of all results in the response
+    static void decode(const std::string &response, const RowCallback &onRow);
+
+    // rows decoded by the transport are passed on as they are
+    static void decode(QueryResponse response, const RowCallback &onRow);
+
+    bool null() override;
+    bool boolean(bool value) override;
+    bool number_integer(number_integer_t value) override;
+    bool number_unsigned(number_unsigned_t value) override;
+    bool number_float(number_float_t value, const string_t &text) override;
+    bool string(string_t &value) override;
+    bool binary(binary_t &value) override;
+
+    bool start_object(std::size_t elements) override;
+    bool key(string_t &value) override;
+    bool end_object() override;
+
+    bool start_array(std::size_t elements) override;
+    bool end_array() override;
+
+    bool parse_error(std::size_t position, const std::string &token,
+                     const nlohmann::detail::exception &error) override;
+
+   private:
+    explicit ResultDecoder(const RowCallback &onRow) : m_onRow(onRow) {}
+
+    // position in the response: {"results":[{"data":[{"row":[...]}]}]}
+    enum class Level { Root, Results, Result, Data, Entry, Row, List, Map,
+                       Nested };
+
+    // scalar value, "text" as json text, "plain" for list entries and columns
+    void value(const std::string &text, const std::string &plain);
+
+    // containers outside of the rows (e.g. "errors", "meta") are skipped
+    void startContainer(bool isObject);
+    void endContainer();
+
+    // appends json text to the nested value, separated by commas
+    void appendNested(const std::string &text);
+
+    const RowCallback &m_onRow;
+
+    std::vector<Level> m_levels;
+    std::string m_key;  // last key of the Root, Result or Entry object
+
+    // depth of a skipped container (e.g. "errors", "meta"), 0 if none
+    size_t m_skipDepth = 0;
+
+    ResultRow m_row;
+
+    // nested values (lists or maps inside a column value) are kept as text,
+    // m_nestedFirst: no entry in the nested container yet
+    std::string m_nested;
+    std::vector<bool> m_nestedFirst;
+    std::vector<bool> m_nestedObject;
+};
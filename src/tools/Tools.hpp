@@ -191,6 +191,15 @@ inline std::string makeString(const std::string str) {
     return ("'" + str + "'");
 }
 
+// converts a neo4j string back to the plain value (used for parameters)
+// "'string'" --> "string"
+inline std::string cypherStringToValue(const std::string &str) {
+    if (str.size() >= 2 && str.front() == '\'' && str.back() == '\'')
+        return str.substr(1, str.size() - 2);
+
+    return str;
+}
+
 inline std::string removeQuotation(std::string str) {
     //  if string contains "" or '' --> remove first and last character
     if (str.find("\"") != std::string::npos ||
@@ -367,10 +376,10 @@ inline std::vector<BYTE> base64Decode(std::string const &encodedString) {
 }
 
 namespace uuid {
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_int_distribution<> dis(0, 15);
-static std::uniform_int_distribution<> dis2(8, 11);
+// one generator per thread, uuids are also created by the async addon workers
+static thread_local std::mt19937 gen(std::random_device{}());
+static thread_local std::uniform_int_distribution<> dis(0, 15);
+static thread_local std::uniform_int_distribution<> dis2(8, 11);
 
 inline std::string generateUuidV4() {
     std::stringstream ss;
@@ -33,6 +33,37 @@ void sortProperties(std::vector<Property> &properties) {
          });
 }
 
+namespace {
+std::string trim(const std::string &str) {
+    size_t first = str.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+
+    size_t last = str.find_last_not_of(" \t");
+    return str.substr(first, last - first + 1);
+}
+}  // namespace
+
+std::string splitRelation(const std::string &relation,
+                          std::vector<Property> &properties) {
+    size_t open = relation.find('{');
+    if (open == std::string::npos) return relation;
+
+    size_t close = relation.rfind('}');
+    if (close == std::string::npos || close < open) close = relation.size();
+
+    auto entries =
+        getListFromStrings(relation.substr(open + 1, close - open - 1), ',');
+    for (auto &entry : entries) {
+        size_t colon = entry.find(':');
+        if (colon == std::string::npos) continue;
+
+        properties.push_back({.variable = trim(entry.substr(0, colon)),
+                              .value = trim(entry.substr(colon + 1))});
+    }
+
+    return trim(relation.substr(0, open));
+}
+
 // Class Node
 Node::Node() : m_variable(""), m_label("") {}
 
@@ -88,6 +119,7 @@ std::string Node::toCypher() {
     std::string label = "";
 
     if (!m_label.empty()) label = ":" + m_label;
+    if (!m_Id.empty()) label += ":" + STEP_ENTITY_LABEL;
 
     if (m_Id.empty()){
         cypher += m_variable + label;
@@ -116,6 +148,34 @@ std::string Node::toCypher() {
     return cypher;
 }
 
+std::string Node::toCypher(json &parameters, const std::string &prefix) {
+    std::string cypher = m_variable;
+    std::string entries = "";
+
+    if (!m_label.empty()) cypher += ":" + m_label;
+
+    if (!m_Id.empty()) {
+        // the Id is looked up through the index of the common label
+        cypher += ":" + STEP_ENTITY_LABEL;
+        parameters[prefix + "_Id"] = m_Id;
+        entries += "Id:$" + prefix + "_Id,";
+    }
+
+    int counter = 0;
+    for (auto &property : m_properties) {
+        std::string parameter = prefix + "_" + std::to_string(counter);
+        parameters[parameter] = cypherStringToValue(property.value);
+        entries += property.variable + ":$" + parameter + ",";
+        ++counter;
+    }
+
+    if (!entries.empty()) {
+        entries.pop_back();
+        cypher += "{" + entries + "}";
+    }
+    return cypher;
+}
+
 void Node::clear() {
     m_Id.clear();
     m_variable.clear();
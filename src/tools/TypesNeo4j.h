@@ -1,7 +1,11 @@
 #pragma once
 
+#include <nlohmann/json.hpp>
+
 #include "Tools.hpp"
 
+using json = nlohmann::json;
+
 /**
  * @brief TypesNeo4j
  * definition of data structures for Neo4j components
@@ -12,6 +16,18 @@ const std::string TYPE_COMPLEX = "COMPLEX_TYPE";
 const std::string TYPE_SET = "SET_TYPE";
 const std::string TYPE_LIST = "LIST_TYPE";
 
+// additional label of every node with an Id, the unique index on Id is
+// defined for this label (see Graph::prepareDatabase)
+const std::string STEP_ENTITY_LABEL = "StepEntity";
+
+// history database: a Branch{name} node points to the latest commit of the
+// branch with a HEAD relation (see VersionControl)
+const std::string BRANCH_LABEL = "Branch";
+const std::string HEAD_RELATION = "HEAD";
+
+// binary dump of the working graph at a commit, split into parts
+const std::string SNAPSHOT_LABEL = "Snapshot";
+
 struct Property {
     std::string variable = "";
     std::string value = "";
@@ -36,6 +52,18 @@ std::string getPropertyStr(const std::vector<Property> &properties);
 
 void sortProperties(std::vector<Property> &properties);
 
+// relation strings may carry properties like in a cypher pattern:
+// "entry{num: 0}" -> type "entry", properties {num, 0} (appended)
+std::string splitRelation(const std::string &relation,
+                          std::vector<Property> &properties);
+
+// directed relation between two nodes (identified by their ids)
+struct Relation {
+    std::string nodeIdFrom;
+    std::string nodeIdTo;
+    std::string relation;
+};
+
 enum class NodeType { COMPLEX, SET, LIST, INSTANCE };
 
 inline std::string nodeTypeToStr(NodeType type) {
@@ -107,6 +135,10 @@ class Node {
     // Returns the cypher string
     std::string toCypher();
 
+    // Returns the cypher string with parameters instead of literal values
+    // e.g. a:Label{Id:$a_Id,name:$a_0}, the values are added to parameters
+    std::string toCypher(json &parameters, const std::string &prefix);
+
     bool isEmpty() {
         return (getLabel().empty() && getId().empty() && m_properties.empty() &&
                 m_variable.empty());
@@ -0,0 +1,260 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BlobCodec.h"
+#include "MemoryGraph.h"
+
+/**
+ * @brief BlobCodecTest
+ * encodes the changes of a commit (raw and zlib, different chunk sizes) and
+ * decodes them again, the values have to be unchanged
+ * truncated blobs are rejected, commits of older versions (modified_N,
+ * node_added_N, relation_added_N strings) are still loaded
+**/
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const std::string &message) {
+    if (condition) return;
+
+    std::cerr << "FAILED: " << message << std::endl;
+    ++failures;
+}
+
+// values the ';' separated strings of older versions could not store
+const std::vector<std::string> VALUES = {
+    "a;b;c", "'quoted'", "\"double\"", "line\nbreak", "", "back\\slash",
+    std::string(200000, 'x')};
+
+Blob createBlob() {
+    Blob blob;
+
+    for (size_t i = 0; i < VALUES.size(); ++i) {
+        std::string index = std::to_string(i);
+
+        blob.addModified({.nodeId = "node_" + index,
+                          .propertyOld = {.variable = "old", .value = ""},
+                          .propertyNew = {.variable = "new",
+                                          .value = VALUES[i]}});
+
+        Node node("node_" + index);
+        node.setLabel("label;" + index);
+        node.addProperty({.variable = "value", .value = VALUES[i]});
+        node.addProperty({.variable = "empty", .value = ""});
+        blob.addNewNode(node);
+
+        blob.addNewRelation(Node("node_" + index), Node(VALUES[i]),
+                            "entry{num: " + index + "}");
+    }
+    return blob;
+}
+
+std::vector<std::string> encode(Blob &blob, bool compress, size_t chunkSize) {
+    std::vector<std::string> chunks;
+    BlobEncoder encoder(compress, chunkSize,
+                        [&chunks](std::string &chunk) {
+                            chunks.push_back(chunk);
+                        });
+    encoder.add(blob);
+    encoder.finish();
+
+    check(encoder.getEncoding() ==
+              (compress ? BLOB_ENCODING_ZLIB : BLOB_ENCODING_RAW),
+          "encoding");
+    return chunks;
+}
+
+Blob decode(const std::string &encoding,
+            const std::vector<std::string> &chunks) {
+    Blob blob;
+    BlobDecoder decoder(
+        encoding, [&blob](Modified &modified) { blob.addModified(modified); },
+        [&blob](Node &node) { blob.addNewNode(node); },
+        [&blob](Relation &relation) {
+            blob.addNewRelation(Node(relation.nodeIdFrom),
+                                Node(relation.nodeIdTo), relation.relation);
+        });
+
+    for (auto &chunk : chunks) decoder.write(chunk);
+    decoder.finish();
+    return blob;
+}
+
+bool equalProperties(Node &first, Node &second) {
+    std::vector<Property> properties = first.getProperties();
+    std::vector<Property> otherProperties = second.getProperties();
+    if (properties.size() != otherProperties.size()) return false;
+
+    for (size_t i = 0; i < properties.size(); ++i)
+        if (properties[i].variable != otherProperties[i].variable ||
+            properties[i].value != otherProperties[i].value)
+            return false;
+    return true;
+}
+
+bool equalBlobs(Blob &first, Blob &second) {
+    auto modified = first.getModified();
+    auto otherModified = second.getModified();
+    if (modified.size() != otherModified.size()) return false;
+
+    for (size_t i = 0; i < modified.size(); ++i)
+        if (modified[i].nodeId != otherModified[i].nodeId ||
+            modified[i].propertyOld.variable !=
+                otherModified[i].propertyOld.variable ||
+            modified[i].propertyOld.value !=
+                otherModified[i].propertyOld.value ||
+            modified[i].propertyNew.variable !=
+                otherModified[i].propertyNew.variable ||
+            modified[i].propertyNew.value !=
+                otherModified[i].propertyNew.value)
+            return false;
+
+    auto nodes = first.getNewNodes();
+    auto otherNodes = second.getNewNodes();
+    if (nodes.size() != otherNodes.size()) return false;
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (nodes[i].getId() != otherNodes[i].getId() ||
+            nodes[i].getLabel() != otherNodes[i].getLabel() ||
+            !equalProperties(nodes[i], otherNodes[i]))
+            return false;
+
+    auto relations = first.getNewRelations();
+    auto otherRelations = second.getNewRelations();
+    if (relations.size() != otherRelations.size()) return false;
+
+    for (size_t i = 0; i < relations.size(); ++i)
+        if (relations[i].nodeIdFrom != otherRelations[i].nodeIdFrom ||
+            relations[i].nodeIdTo != otherRelations[i].nodeIdTo ||
+            relations[i].relation != otherRelations[i].relation)
+            return false;
+    return true;
+}
+
+// chunk sizes from a single byte to more than the whole blob
+void testRoundTrip(bool compress) {
+    Blob blob = createBlob();
+    std::string encoding = compress ? BLOB_ENCODING_ZLIB : BLOB_ENCODING_RAW;
+
+    for (size_t chunkSize : {size_t(1), size_t(3), size_t(100),
+                             size_t(64 << 10), size_t(4 << 20)}) {
+        std::string name =
+            encoding + " with chunks of " + std::to_string(chunkSize);
+        std::vector<std::string> chunks = encode(blob, compress, chunkSize);
+
+        check(!chunks.empty(), name + ": chunks written");
+        for (size_t i = 0; i < chunks.size(); ++i)
+            check(i + 1 == chunks.size() ? chunks[i].size() <= chunkSize
+                                         : chunks[i].size() == chunkSize,
+                  name + ": size of chunk " + std::to_string(i));
+
+        Blob decoded = decode(encoding, chunks);
+        check(equalBlobs(blob, decoded), name + ": values unchanged");
+    }
+
+    // nothing added: only the header
+    Blob empty;
+    Blob decoded = decode(encoding, encode(empty, compress, 16));
+    check(equalBlobs(empty, decoded), encoding + ": empty blob");
+}
+
+bool decodeThrows(const std::string &encoding,
+                  const std::vector<std::string> &chunks) {
+    try {
+        decode(encoding, chunks);
+    } catch (const DatabaseError &) {
+        return true;
+    }
+    return false;
+}
+
+void testTruncated(bool compress) {
+    Blob blob = createBlob();
+    std::string encoding = compress ? BLOB_ENCODING_ZLIB : BLOB_ENCODING_RAW;
+
+    std::string data;
+    for (auto &chunk : encode(blob, compress, 1 << 20)) data += chunk;
+
+    check(decodeThrows(encoding, {}), encoding + ": no data");
+    check(decodeThrows(encoding, {data.substr(0, data.size() - 1)}),
+          encoding + ": last byte missing");
+    check(decodeThrows(encoding, {data.substr(0, data.size() / 2)}),
+          encoding + ": second half missing");
+    check(!decodeThrows(encoding, {data}), encoding + ": complete data");
+}
+
+void testUnknownEncoding() {
+    bool thrown = false;
+    try {
+        BlobDecoder decoder(
+            "lz4", [](Modified &) {}, [](Node &) {}, [](Relation &) {});
+    } catch (const DatabaseError &) {
+        thrown = true;
+    }
+    check(thrown, "unknown encoding is rejected");
+}
+
+// commits written before the blob encoding existed
+void testOlderCommit() {
+    DatabaseInfo work = {.hostName = MEMORY_HOST,
+                         .databaseName = "blob_codec_work"};
+    std::shared_ptr<MemoryGraph> store =
+        MemoryGraph::getStore(work.databaseName);
+    store->clear();
+
+    Node point("#1");
+    point.setLabel("cartesian_point");
+    point.addProperty({.variable = "coordinates", .value = "'(0.,0.,0.)'"});
+    store->createNode(point);
+
+    // property values as they are read from the history database
+    Node commit("commit_1");
+    commit.setLabel("point_moved");
+    commit.addProperty(
+        {.variable = "modified_0",
+         .value = "#1;coordinates;(0.,0.,0.);coordinates;(1.,2.,3.);"});
+    commit.addProperty({.variable = "node_added_0",
+                        .value = "cartesian_point;Id;#2;name;origin;"});
+    commit.addProperty(
+        {.variable = "relation_added_0", .value = "#2;#1;location"});
+
+    VersionControl control(work);
+    control.loadCommit(commit);
+
+    std::vector<Node> moved = store->matchNodes(Node("#1"));
+    check(moved.size() == 1 &&
+              cypherStringToValue(
+                  moved[0].getProperty("coordinates").value) ==
+                  "(1.,2.,3.)",
+          "modified_N is applied");
+
+    std::vector<Node> added = store->matchNodes(Node("#2"));
+    check(added.size() == 1 && added[0].getLabel() == "cartesian_point" &&
+              cypherStringToValue(added[0].getProperty("name").value) ==
+                  "origin",
+          "node_added_N is applied");
+
+    auto children = store->getChildren(Node("#2"));
+    check(children.size() == 1 && children[0].first.getId() == "#1" &&
+              children[0].second == "location",
+          "relation_added_N is applied");
+
+    store->clear();
+}
+}  // namespace
+
+int main() {
+    for (bool compress : {false, true}) {
+        testRoundTrip(compress);
+        testTruncated(compress);
+    }
+    testUnknownEncoding();
+    testOlderCommit();
+
+    if (failures > 0) return 1;
+
+    std::cout << "all tests passed" << std::endl;
+    return 0;
+}
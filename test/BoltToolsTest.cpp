@@ -0,0 +1,390 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoltTools.h"
+#include "DatabaseError.hpp"
+
+/**
+ * @brief BoltToolsTest
+ * runs BoltInterface against a scripted stand-in server on localhost
+ * the server checks the messages of the client and answers with prepared
+ * responses: handshake, HELLO, a transaction with records (one of them
+ * larger than a chunk), a FAILURE followed by RESET and a transaction on
+ * the reset connection
+**/
+
+namespace {
+// checked by the client and the server thread
+std::atomic<int> failures = 0;
+
+void check(bool condition, const std::string &message) {
+    if (condition) return;
+
+    std::cerr << "FAILED: " << message << std::endl;
+    ++failures;
+}
+
+// message signatures
+const uint8_t HELLO = 0x01;
+const uint8_t RESET = 0x0F;
+const uint8_t RUN = 0x10;
+const uint8_t BEGIN = 0x11;
+const uint8_t COMMIT = 0x12;
+const uint8_t PULL = 0x3F;
+const uint8_t SUCCESS = 0x70;
+const uint8_t RECORD = 0x71;
+const uint8_t IGNORED = 0x7E;
+const uint8_t FAILURE = 0x7F;
+
+// larger than a chunk (0xFFFF bytes)
+const std::string LARGE_TEXT(100000, 'x');
+
+// PackStream encoding of the responses
+std::string packHeader(size_t size, uint8_t tiny, uint8_t marker) {
+    std::string data;
+    if (size < 0x10) {
+        data += char(tiny | size);
+    } else if (size <= 0xFF) {
+        data += char(marker);
+        data += char(size);
+    } else if (size <= 0xFFFF) {
+        data += char(marker + 1);
+        data += char(size >> 8);
+        data += char(size & 0xFF);
+    } else {
+        data += char(marker + 2);
+        for (int shift = 24; shift >= 0; shift -= 8)
+            data += char((size >> shift) & 0xFF);
+    }
+    return data;
+}
+
+std::string packString(const std::string &value) {
+    return packHeader(value.size(), 0x80, 0xD0) + value;
+}
+
+std::string packList(const std::vector<std::string> &entries) {
+    std::string data = packHeader(entries.size(), 0x90, 0xD4);
+    for (auto &entry : entries) data += entry;
+    return data;
+}
+
+// entries: packed key and value pairs
+std::string packMap(
+    const std::vector<std::pair<std::string, std::string>> &entries) {
+    std::string data = packHeader(entries.size(), 0xA0, 0xD8);
+    for (auto &[key, value] : entries) data += packString(key) + value;
+    return data;
+}
+
+std::string packTinyInt(int value) { return std::string(1, char(value)); }
+
+std::string packFloat(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    std::string data(1, char(0xC1));
+    for (int shift = 56; shift >= 0; shift -= 8)
+        data += char((bits >> shift) & 0xFF);
+    return data;
+}
+
+std::string packStruct(uint8_t tag, const std::vector<std::string> &fields) {
+    std::string data;
+    data += char(0xB0 | fields.size());
+    data += char(tag);
+    for (auto &field : fields) data += field;
+    return data;
+}
+
+// the scripted server side of one connection
+class StandInServer {
+   public:
+    StandInServer() {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        bind(m_listener, (sockaddr *)&address, sizeof(address));
+        listen(m_listener, 1);
+
+        socklen_t length = sizeof(address);
+        getsockname(m_listener, (sockaddr *)&address, &length);
+        m_port = ntohs(address.sin_port);
+    }
+
+    ~StandInServer() {
+        if (m_connection >= 0) close(m_connection);
+        close(m_listener);
+    }
+
+    int getPort() { return m_port; }
+
+    void accept() { m_connection = ::accept(m_listener, nullptr, nullptr); }
+
+    void handshake() {
+        std::string request = receive(20);
+        check(request.substr(0, 4) == "\x60\x60\xB0\x17",
+              "handshake starts with the magic preamble");
+        check(request.substr(4, 4) == std::string("\0\0\0\5", 4),
+              "handshake proposes version 5.0 first");
+
+        send(std::string("\0\0\4\4", 4));
+    }
+
+    // next message of the client, body: the fields
+    uint8_t expect(uint8_t signature, std::string &body,
+                   const std::string &name) {
+        std::string message;
+        while (true) {
+            std::string size = receive(2);
+            size_t length = (uint8_t(size[0]) << 8) | uint8_t(size[1]);
+            if (length == 0) break;
+
+            message += receive(length);
+        }
+
+        check(message.size() >= 2 && uint8_t(message[1]) == signature,
+              name + " was sent");
+        body = message.size() >= 2 ? message.substr(2) : "";
+        return message.size() >= 2 ? uint8_t(message[1]) : 0;
+    }
+
+    void expect(uint8_t signature, const std::string &name) {
+        std::string body;
+        expect(signature, body, name);
+    }
+
+    // messages are split into chunks of at most 0xFFFF bytes
+    void respond(uint8_t signature, const std::vector<std::string> &fields) {
+        std::string message = packStruct(signature, fields);
+
+        std::string data;
+        for (size_t offset = 0; offset < message.size(); offset += 0xFFFF) {
+            size_t size = std::min<size_t>(0xFFFF, message.size() - offset);
+            data += char(size >> 8);
+            data += char(size & 0xFF);
+            data += message.substr(offset, size);
+        }
+        data += std::string(2, '\0');
+        send(data);
+    }
+
+   private:
+    std::string receive(size_t size) {
+        std::string data(size, '\0');
+        size_t offset = 0;
+        while (offset < size) {
+            ssize_t received =
+                recv(m_connection, data.data() + offset, size - offset, 0);
+            if (received <= 0) throw_database_error("client disconnected");
+            offset += received;
+        }
+        return data;
+    }
+
+    void send(const std::string &data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t sent = ::send(m_connection, data.data() + offset,
+                                  data.size() - offset, MSG_NOSIGNAL);
+            if (sent <= 0) throw_database_error("client disconnected");
+            offset += sent;
+        }
+    }
+
+    int m_listener = -1;
+    int m_connection = -1;
+    int m_port = 0;
+};
+
+void runServer(StandInServer &server) {
+    server.accept();
+    server.handshake();
+
+    std::string body;
+    server.expect(HELLO, body, "HELLO");
+    check(body.find("basic") != std::string::npos &&
+              body.find("neo4j") != std::string::npos &&
+              body.find("secret") != std::string::npos,
+          "HELLO contains the credentials");
+    server.respond(SUCCESS,
+                   {packMap({{"server", packString("Neo4j/5.0.0")}})});
+
+    // transaction with two statements, the parameter exceeds one chunk
+    server.expect(BEGIN, body, "BEGIN");
+    check(body.find("testdb") != std::string::npos, "BEGIN selects the db");
+    server.expect(RUN, body, "RUN");
+    check(body.find("RETURN $text") != std::string::npos &&
+              body.find(LARGE_TEXT) != std::string::npos,
+          "RUN contains statement and parameters");
+    server.expect(PULL, "PULL");
+    server.expect(RUN, body, "second RUN");
+    check(body.find("MATCH (n)") != std::string::npos,
+          "second RUN contains its statement");
+    server.expect(PULL, "second PULL");
+    server.expect(COMMIT, "COMMIT");
+
+    server.respond(SUCCESS, {packMap({})});
+    server.respond(SUCCESS,
+                   {packMap({{"fields", packList({packString("text")})}})});
+    server.respond(RECORD, {packList({packString(LARGE_TEXT)})});
+    server.respond(SUCCESS, {packMap({})});
+    server.respond(SUCCESS,
+                   {packMap({{"fields", packList({packString("n")})}})});
+
+    // node (id, labels, properties), labels, integer, empty string
+    std::string node = packStruct(
+        0x4E, {packTinyInt(1), packList({packString("Shape")}),
+               packMap({{"size", packFloat(1.5)},
+                        {"name", packString("cube")},
+                        {"tags", packList({packString("a")})}})});
+    server.respond(
+        RECORD,
+        {packList({node,
+                   packList({packString("Shape"), packString("StepEntity")}),
+                   packTinyInt(-3), packString("")})});
+    server.respond(SUCCESS, {packMap({})});
+    server.respond(SUCCESS, {packMap({{"bookmark", packString("b1")}})});
+
+    // failure: the remaining messages are ignored until RESET
+    server.expect(BEGIN, "BEGIN of the failing transaction");
+    server.expect(RUN, "RUN of the failing transaction");
+    server.expect(PULL, "PULL of the failing transaction");
+    server.expect(COMMIT, "COMMIT of the failing transaction");
+
+    server.respond(SUCCESS, {packMap({})});
+    server.respond(
+        FAILURE,
+        {packMap({{"code", packString("Neo.ClientError.Statement.SyntaxError")},
+              {"message", packString("Invalid input")}})});
+    server.respond(IGNORED, {});
+    server.respond(IGNORED, {});
+
+    server.expect(RESET, "RESET after the failure");
+    server.respond(SUCCESS, {packMap({})});
+
+    // the connection is usable again
+    server.expect(BEGIN, "BEGIN after RESET");
+    server.expect(RUN, "RUN after RESET");
+    server.expect(PULL, "PULL after RESET");
+    server.expect(COMMIT, "COMMIT after RESET");
+
+    server.respond(SUCCESS, {packMap({})});
+    server.respond(SUCCESS,
+                   {packMap({{"fields", packList({packString("ok")})}})});
+    server.respond(RECORD, {packList({packString("ok")})});
+    server.respond(SUCCESS, {packMap({})});
+    server.respond(SUCCESS, {packMap({})});
+}
+
+void runClient(int port) {
+    BoltInterface bolt("bolt://127.0.0.1:" + std::to_string(port) + "/",
+                       "neo4j", "secret", "testdb");
+
+    QueryResponse response;
+    HttpState state = bolt.postRequest(
+        {CypherQuery{.statement = "RETURN $text",
+                     .parameters = {{"text", LARGE_TEXT}}},
+         CypherQuery{.statement = "MATCH (n) RETURN n, labels(n), -3, ''"}},
+        response);
+
+    check(state == HttpState::HTTP_OK, "transaction succeeds");
+    check(response.errors.empty(), "transaction has no errors");
+    check(response.rows.size() == 2, "rows of both statements");
+    if (response.rows.size() == 2) {
+        ResultRow &large = response.rows[0];
+        check(large.size() == 1 &&
+                  large[0].type == ResultValue::Type::Scalar &&
+                  large[0].value == LARGE_TEXT,
+              "record larger than a chunk");
+
+        ResultRow &row = response.rows[1];
+        check(row.size() == 4, "columns of the node record");
+        if (row.size() == 4) {
+            // node: properties sorted by key, values as json text
+            check(row[0].type == ResultValue::Type::Map &&
+                      row[0].fields.size() == 3 &&
+                      row[0].fields[0].variable == "name" &&
+                      row[0].fields[0].value == "\"cube\"" &&
+                      row[0].fields[1].variable == "size" &&
+                      row[0].fields[1].value == "1.5" &&
+                      row[0].fields[2].value == "[\"a\"]",
+                  "node decoded to its properties");
+            check(row[1].type == ResultValue::Type::List &&
+                      row[1].entries ==
+                          std::vector<std::string>{"Shape", "StepEntity"},
+                  "list of labels");
+            check(row[2].type == ResultValue::Type::Scalar &&
+                      row[2].value == "-3",
+                  "negative tiny integer");
+            check(row[3].type == ResultValue::Type::Scalar &&
+                      row[3].value.empty(),
+                  "empty string");
+        }
+    }
+
+    size_t numRows = 0;
+    ResultDecoder::decode(response, [&numRows](ResultRow &) { ++numRows; });
+    check(numRows == 2, "decoder passes the rows on");
+
+    response = QueryResponse();
+    state = bolt.postRequest({CypherQuery{.statement = "RETRUN 1"}}, response);
+    check(state == HttpState::HTTP_OK, "failed transaction is answered");
+    check(response.errors.size() == 1 &&
+              response.errors[0].code ==
+                  "Neo.ClientError.Statement.SyntaxError" &&
+              response.errors[0].message == "Invalid input",
+          "failure is reported");
+    check(response.rows.empty(), "failed transaction has no rows");
+
+    bool thrown = false;
+    try {
+        checkResponseForErrors(response);
+    } catch (const DatabaseError &) {
+        thrown = true;
+    }
+    check(thrown, "checkResponseForErrors throws the failure");
+
+    response = QueryResponse();
+    state = bolt.postRequest({CypherQuery{.statement = "RETURN 'ok'"}},
+                             response);
+    check(state == HttpState::HTTP_OK && response.errors.empty() &&
+              response.rows.size() == 1 &&
+              response.rows[0][0].value == "ok",
+          "connection is reused after RESET");
+}
+}  // namespace
+
+int main() {
+    StandInServer server;
+
+    std::thread serverThread([&server] {
+        try {
+            runServer(server);
+        } catch (const std::exception &e) {
+            check(false, std::string("server: ") + e.what());
+        }
+    });
+
+    runClient(server.getPort());
+    serverThread.join();
+
+    if (failures > 0) return 1;
+
+    std::cout << "all tests passed" << std::endl;
+    return 0;
+}
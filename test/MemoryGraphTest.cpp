@@ -0,0 +1,115 @@
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+#include "MemoryGraph.h"
+#include "PullStep.h"
+#include "PushStep.h"
+
+/**
+ * @brief MemoryGraphTest
+ * pushes a STEP file into the in-memory backend, pulls it into a new file
+ * and pushes that file again, both graphs have to be equal (apart from the
+ * file ids)
+**/
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const std::string &message) {
+    if (condition) return;
+
+    std::cerr << "FAILED: " << message << std::endl;
+    ++failures;
+}
+
+DatabaseInfo memoryDatabase(const std::string &name) {
+    return {.hostName = MEMORY_HOST, .databaseName = name};
+}
+
+// label and properties of every node (ids differ between the files)
+std::map<std::string, size_t> nodeSignatures(Graph &graph) {
+    std::map<std::string, size_t> signatures;
+    for (auto &node : graph.getAllNodes()) {
+        std::vector<Property> properties = node.getProperties();
+        sortProperties(properties);
+        ++signatures[node.getLabel() + propertiesToString(properties)];
+    }
+    return signatures;
+}
+
+// relation types with the labels of both ends
+std::map<std::string, size_t> relationSignatures(Graph &graph) {
+    std::map<std::string, std::string> labels;
+    for (auto &node : graph.getAllNodes())
+        labels[node.getId()] = node.getLabel();
+
+    std::map<std::string, size_t> signatures;
+    for (auto &relation : graph.getAllRelations())
+        ++signatures[labels[relation.nodeIdFrom] + "-" + relation.relation +
+                     "->" + labels[relation.nodeIdTo]];
+    return signatures;
+}
+
+// relation strings with properties keep only the type (like Neo4j)
+void testRelationType() {
+    MemoryGraph store;
+    store.createNode(Node("a"));
+    store.createNode(Node("b"));
+    store.createRelation(Node("a"), Node("b"), "entry{num: 0}");
+
+    auto children = store.getChildren(Node("a"));
+    check(children.size() == 1 && children[0].second == "entry",
+          "relation type without properties");
+
+    auto relations = store.getAllRelations();
+    check(relations.size() == 1 && relations[0].relation == "entry",
+          "relation type of getAllRelations");
+}
+
+void testRoundTrip(const std::string &stepFile,
+                   const std::filesystem::path &outputFile) {
+    DatabaseInfo original = memoryDatabase("round_trip_original");
+    DatabaseInfo reloaded = memoryDatabase("round_trip_reloaded");
+
+    PushSTEP push(stepFile, original);
+    push.deleteDatabase();
+    check(push.build(), "push of " + stepFile);
+
+    PullSTEP pull(outputFile.string(), original);
+    check(pull.writeStep() == 0, "pull into " + outputFile.string());
+
+    PushSTEP pushAgain(outputFile.string(), reloaded);
+    pushAgain.deleteDatabase();
+    check(pushAgain.build(), "push of the pulled file");
+
+    check(push.countNodes() > 0, "nodes were pushed");
+    check(push.countNodes() == pushAgain.countNodes(), "number of nodes");
+    check(push.countRelations() == pushAgain.countRelations(),
+          "number of relations");
+    check(nodeSignatures(push) == nodeSignatures(pushAgain),
+          "labels and properties of the nodes");
+    check(relationSignatures(push) == relationSignatures(pushAgain),
+          "relations");
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "usage: MemoryGraphTest <data directory>" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path output =
+        std::filesystem::temp_directory_path() / "memory_graph_test_out.stp";
+
+    testRelationType();
+    testRoundTrip(std::string(argv[1]) + "/test_cube.stp", output);
+
+    std::filesystem::remove(output);
+
+    if (failures > 0) return 1;
+
+    std::cout << "all tests passed" << std::endl;
+    return 0;
+}